@@ -0,0 +1,37 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "clock_angles.h"
+
+#define MS_PER_MINUTE 60000
+
+int32_t clock_angle_minute(int minute) {
+  return minute * TRIG_MAX_ANGLE / 60;
+}
+
+int32_t clock_angle_hour(int hour, int minute) {
+  return ((hour % 12) * 60 + minute) * TRIG_MAX_ANGLE / (12 * 60);
+}
+
+// ahead_ms moves the hand forward, e.g. to where it will be when an
+// animation ends. A quarter turn is scaled so the product fits 32 bits.
+int32_t clock_angle_second(int second, int32_t ahead_ms) {
+  return (second * 1000 + ahead_ms) * (TRIG_MAX_ANGLE / 4) / (MS_PER_MINUTE / 4);
+}
@@ -0,0 +1,31 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <pebble.h>
+
+// Time to hand angle conversions. Every angle in the watchface is in
+// TRIG_MAX_ANGLE units and computed with integer math only, which gives
+// the hands sub-degree resolution (the hour hand moves every minute).
+
+#define CLOCK_ANGLE_DEGREES(degrees) ((degrees) * TRIG_MAX_ANGLE / 360)
+
+int32_t clock_angle_minute(int minute);
+int32_t clock_angle_hour(int hour, int minute);
+int32_t clock_angle_second(int second, int32_t ahead_ms);
@@ -0,0 +1,160 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "dial_cache.h"
+#include "render_stats.h"
+#include <pebble.h>
+#include "memory_stats.h"
+
+static GBitmap *s_cache;
+static GRect s_cache_bounds;
+static bool s_cache_valid;
+
+void dial_cache_invalidate(void) {
+  s_cache_valid = false;
+}
+
+bool dial_cache_draw(GContext *ctx, GRect bounds) {
+  if (!s_cache_valid || !grect_equal(&bounds, &s_cache_bounds)) {
+    return false;
+  }
+  graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+  graphics_draw_bitmap_in_rect(ctx, s_cache, gbitmap_get_bounds(s_cache));
+  return true;
+}
+
+static void prv_copy_row(GBitmapFormat format, GBitmapDataRowInfo from, GBitmapDataRowInfo to,
+                         int min_x, int max_x) {
+  if (format == GBitmapFormat1Bit) {
+    // rows start at x = 0 on both bitmaps, so whole bytes can be copied
+    memcpy(&to.data[min_x / 8], &from.data[min_x / 8], max_x / 8 - min_x / 8 + 1);
+  }
+  else {
+    memcpy(&to.data[min_x], &from.data[min_x], max_x - min_x + 1);
+  }
+}
+
+// Copies the freshly drawn dial out of the frame buffer. The cached bitmap
+// spans from the screen origin so its rows line up byte for byte with the
+// frame buffer ones, also on 1-bit displays.
+void dial_cache_store(GContext *ctx, GRect bounds) {
+  GSize size = GSize(bounds.origin.x + bounds.size.w, bounds.origin.y + bounds.size.h);
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (!frame_buffer) {
+    return;
+  }
+  GBitmapFormat format = gbitmap_get_format(frame_buffer) == GBitmapFormat1Bit
+                         ? GBitmapFormat1Bit : GBitmapFormat8Bit;
+  if (s_cache) {
+    GRect cache_bounds = gbitmap_get_bounds(s_cache);
+    if (!gsize_equal(&cache_bounds.size, &size)) {
+      dial_cache_destroy();
+    }
+  }
+  if (!s_cache) {
+    s_cache = gbitmap_create_blank(size, format);
+  }
+  if (s_cache) {
+    for (int y = bounds.origin.y; y < size.h; y++) {
+      GBitmapDataRowInfo from = gbitmap_get_data_row_info(frame_buffer, y);
+      GBitmapDataRowInfo to = gbitmap_get_data_row_info(s_cache, y);
+      int min_x = from.min_x > bounds.origin.x ? from.min_x : bounds.origin.x;
+      int max_x = from.max_x < size.w - 1 ? from.max_x : size.w - 1;
+      if (min_x <= max_x) {
+        prv_copy_row(format, from, to, min_x, max_x);
+      }
+    }
+    s_cache_bounds = bounds;
+    s_cache_valid = true;
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+}
+
+static int prv_clamp(int value, int min, int max) {
+  return value < min ? min : (value > max ? max : value);
+}
+
+static void prv_copy_pixel(GBitmapFormat format, GBitmapDataRowInfo from, int from_x,
+                           GBitmapDataRowInfo to, int to_x) {
+  if (format == GBitmapFormat1Bit) {
+    uint8_t bit = 1 << (to_x % 8);
+    if (from.data[from_x / 8] & (1 << (from_x % 8))) {
+      to.data[to_x / 8] |= bit;
+    }
+    else {
+      to.data[to_x / 8] &= ~bit;
+    }
+  }
+  else {
+    to.data[to_x] = from.data[from_x];
+  }
+}
+
+// Draws the cached dial scaled around its center to fit other bounds,
+// nearest neighbour. The dial is a circle fitted in the bounds, so the
+// scale is the ratio of their shorter sides; pixels past the cached area
+// repeat its edge, which is plain background.
+bool dial_cache_draw_scaled(GContext *ctx, GRect bounds) {
+  if (!s_cache_valid) {
+    return false;
+  }
+  if (grect_equal(&bounds, &s_cache_bounds)) {
+    return dial_cache_draw(ctx, bounds);
+  }
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (!frame_buffer) {
+    return false;
+  }
+  GBitmapFormat format = gbitmap_get_format(frame_buffer) == GBitmapFormat1Bit
+                         ? GBitmapFormat1Bit : GBitmapFormat8Bit;
+  const GRect from = s_cache_bounds;
+  int from_side = from.size.w < from.size.h ? from.size.w : from.size.h;
+  int to_side = bounds.size.w < bounds.size.h ? bounds.size.w : bounds.size.h;
+  // source pixels per destination pixel, 16.16 fixed point
+  int32_t step = (from_side << 16) / to_side;
+  int from_cx = from.origin.x + from.size.w / 2;
+  int from_cy = from.origin.y + from.size.h / 2;
+  int to_cx = bounds.origin.x + bounds.size.w / 2;
+  int to_cy = bounds.origin.y + bounds.size.h / 2;
+  for (int y = bounds.origin.y; y < bounds.origin.y + bounds.size.h; y++) {
+    int from_y = prv_clamp(from_cy + (((y - to_cy) * step) >> 16),
+                           from.origin.y, from.origin.y + from.size.h - 1);
+    GBitmapDataRowInfo to = gbitmap_get_data_row_info(frame_buffer, y);
+    GBitmapDataRowInfo row = gbitmap_get_data_row_info(s_cache, from_y);
+    int min_x = to.min_x > bounds.origin.x ? to.min_x : bounds.origin.x;
+    int max_x = to.max_x < bounds.origin.x + bounds.size.w - 1
+                ? to.max_x : bounds.origin.x + bounds.size.w - 1;
+    for (int x = min_x; x <= max_x; x++) {
+      int from_x = prv_clamp(from_cx + (((x - to_cx) * step) >> 16),
+                             from.origin.x, from.origin.x + from.size.w - 1);
+      prv_copy_pixel(format, row, from_x, to, x);
+    }
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+  return true;
+}
+
+void dial_cache_destroy(void) {
+  if (s_cache) {
+    gbitmap_destroy(s_cache);
+    s_cache = NULL;
+  }
+  s_cache_valid = false;
+}
@@ -0,0 +1,47 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <pebble.h>
+
+// Off-screen copy of the static dial (background, marks and labels).
+// The dial only changes on config or bounds changes, so every other
+// frame can blit this bitmap instead of rasterizing it again.
+//
+// A full screen bitmap is too much for the small heap of the 1-bit
+// platforms, which replay a display list of the dial instead (see
+// dial_list.h). The strategy is picked at build time, and can be forced
+// with VUELA_DIAL_CACHE=bitmap or list.
+
+#define DIAL_CACHE_BITMAP 1
+#define DIAL_CACHE_LIST 2
+
+#if !defined(DIAL_CACHE_STRATEGY)
+#if defined(PBL_PLATFORM_APLITE) || defined(PBL_PLATFORM_DIORITE)
+#define DIAL_CACHE_STRATEGY DIAL_CACHE_LIST
+#else
+#define DIAL_CACHE_STRATEGY DIAL_CACHE_BITMAP
+#endif
+#endif
+
+void dial_cache_invalidate(void);
+bool dial_cache_draw(GContext *ctx, GRect bounds);
+bool dial_cache_draw_scaled(GContext *ctx, GRect bounds);
+void dial_cache_store(GContext *ctx, GRect bounds);
+void dial_cache_destroy(void);
@@ -0,0 +1,46 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "dial_geometry.h"
+#include <pebble.h>
+
+bool dial_geometry_tables_match(GRect bounds) {
+  return bounds.origin.x == 0 && bounds.origin.y == 0 &&
+         gsize_equal(&bounds.size, &dial_tables_size);
+}
+
+GRect dial_geometry_frame(DialRing ring, GRect bounds) {
+  const DialRingSpec *spec = &dial_rings[ring];
+  GRect frame = (GRect) { .size = GSize(bounds.size.w * spec->scale / 1000,
+                                        bounds.size.h * spec->scale / 1000) };
+  grect_align(&frame, &bounds, GAlignCenter, false);
+  frame.origin.x += spec->offset_x;
+  frame.origin.y += spec->offset_y;
+  return frame;
+}
+
+GPoint dial_geometry_table_point(DialRing ring, int32_t angle) {
+  const DialRingSpec *spec = &dial_rings[ring];
+  int32_t offset = (angle - spec->first_angle) % TRIG_MAX_ANGLE;
+  if (offset < 0) offset += TRIG_MAX_ANGLE;
+  int32_t index = (offset * spec->steps + TRIG_MAX_ANGLE / 2) / TRIG_MAX_ANGLE;
+  const DialPoint point = spec->points[index % spec->steps];
+  return GPoint(point.x, point.y);
+}
@@ -0,0 +1,31 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <pebble.h>
+#include "dial_tables.h"
+
+// Points on the dial rings. While the dial covers the whole screen they
+// come from the tables generated at build time for the platform, otherwise
+// (e.g. with a Timeline Quick View on screen) they are computed on the
+// ring frame. Angles are in TRIG_MAX_ANGLE units, see clock_angles.h.
+
+bool dial_geometry_tables_match(GRect bounds);
+GRect dial_geometry_frame(DialRing ring, GRect bounds);
+GPoint dial_geometry_table_point(DialRing ring, int32_t angle);
@@ -0,0 +1,117 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "dial_layout.h"
+#include "clock_angles.h"
+#include <pebble.h>
+
+static GRect prv_label_box(const DialLayout *layout, DialRing ring, int32_t angle,
+                           const char *text, GFont font) {
+  GSize size = graphics_text_layout_get_content_size(text, font, layout->bounds,
+                                                     GTextOverflowModeFill,
+                                                     GTextAlignmentCenter);
+  GPoint center = dial_layout_point(layout, ring, angle);
+  return (GRect) {
+    .origin = GPoint(center.x - size.w / 2, center.y - size.h / 2),
+    .size = size
+  };
+}
+
+void dial_layout_update(DialLayout *layout, GRect bounds, GFont font, bool square_font) {
+  int w = bounds.size.w;
+  int h = bounds.size.h;
+  layout->bounds = bounds;
+  layout->center = GPoint(bounds.origin.x + w / 2, bounds.origin.y + h / 2);
+  layout->dial_frame = (GRect) { .size = GSize(w, h) };
+  grect_align(&layout->dial_frame, &bounds, GAlignCenter, false);
+  layout->dial_inset = w * 49 / 100;
+  layout->hour_circle_radius = h / 4 < 35 ? 35 : h / 4;
+  layout->use_tables = dial_geometry_tables_match(bounds);
+  for (int ring = 0; ring < DIAL_RING_COUNT; ring++) {
+    layout->ring_frames[ring] = dial_geometry_frame(ring, bounds);
+  }
+  // the first frame of a cold start has no numerals and no font yet
+  char text[5];
+  for (int i = 0; i < DIAL_LABEL_COUNT && font; i++) {
+    int min = (i + 1) * 5;
+    snprintf(text, sizeof(text), "%02d", min);
+    layout->minute_label_boxes[i] = prv_label_box(layout, DIAL_RING_MINUTE_LABEL,
+                                                  clock_angle_minute(min), text, font);
+    int hour = i + 1;
+    snprintf(text, sizeof(text), "%d", hour);
+    layout->hour_label_boxes[i] = prv_label_box(layout, DIAL_RING_HOUR_LABEL,
+                                                clock_angle_hour(hour, 0), text, font);
+    // the square font sits one pixel low
+    layout->hour_label_boxes[i].origin.y -= square_font ? 1 : 0;
+  }
+  layout->date_box = (GRect) {
+    .size = GSize(16, 15),
+    .origin = dial_layout_point(layout, DIAL_RING_DATE, CLOCK_ANGLE_DEGREES(83))
+  };
+  layout->date_bg = grect_inset(layout->date_box, GEdgeInsets(square_font ? -1 : -2, 1, 0, 0));
+}
+
+static GPoint prv_scale_point(GPoint point, GPoint from, GPoint to, int num, int den) {
+  return GPoint(to.x + (point.x - from.x) * num / den, to.y + (point.y - from.y) * num / den);
+}
+
+static GRect prv_scale_box(GRect box, GPoint from, GPoint to, int num, int den) {
+  GPoint center = GPoint(box.origin.x + box.size.w / 2, box.origin.y + box.size.h / 2);
+  center = prv_scale_point(center, from, to, num, den);
+  box.origin = GPoint(center.x - box.size.w / 2, center.y - box.size.h / 2);
+  return box;
+}
+
+// Cheap approximation of the layout for new bounds: the dial shrinks or
+// grows around its center, label and date boxes keep their size and only
+// move. Good enough for the frames of an unobstructed area transition.
+void dial_layout_scale(DialLayout *layout, const DialLayout *from, GRect bounds) {
+  int num = bounds.size.w < bounds.size.h ? bounds.size.w : bounds.size.h;
+  int den = from->bounds.size.w < from->bounds.size.h ? from->bounds.size.w
+                                                      : from->bounds.size.h;
+  int w = bounds.size.w;
+  int h = bounds.size.h;
+  GPoint center = GPoint(bounds.origin.x + w / 2, bounds.origin.y + h / 2);
+  layout->bounds = bounds;
+  layout->center = center;
+  layout->dial_frame = (GRect) { .size = GSize(w, h) };
+  grect_align(&layout->dial_frame, &bounds, GAlignCenter, false);
+  layout->dial_inset = w * 49 / 100;
+  layout->hour_circle_radius = from->hour_circle_radius * num / den;
+  layout->use_tables = dial_geometry_tables_match(bounds);
+  for (int ring = 0; ring < DIAL_RING_COUNT; ring++) {
+    layout->ring_frames[ring] = dial_geometry_frame(ring, bounds);
+  }
+  for (int i = 0; i < DIAL_LABEL_COUNT; i++) {
+    layout->minute_label_boxes[i] = prv_scale_box(from->minute_label_boxes[i], from->center,
+                                                  center, num, den);
+    layout->hour_label_boxes[i] = prv_scale_box(from->hour_label_boxes[i], from->center,
+                                                center, num, den);
+  }
+  layout->date_box = prv_scale_box(from->date_box, from->center, center, num, den);
+  layout->date_bg = prv_scale_box(from->date_bg, from->center, center, num, den);
+}
+
+GPoint dial_layout_point(const DialLayout *layout, DialRing ring, int32_t angle) {
+  if (layout->use_tables && dial_rings[ring].points) {
+    return dial_geometry_table_point(ring, angle);
+  }
+  return gpoint_from_polar(layout->ring_frames[ring], GOvalScaleModeFitCircle, angle);
+}
@@ -0,0 +1,60 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <pebble.h>
+#include "dial_geometry.h"
+
+#define DIAL_LABEL_COUNT 12
+
+// Planes of the face, drawn bottom to top by the compositor.
+typedef enum {
+  DIAL_PLANE_MARKS,
+  DIAL_PLANE_DAY,
+  DIAL_PLANE_CLOCK,
+  DIAL_PLANE_SECONDS,
+  DIAL_PLANE_COUNT
+} DialPlane;
+
+#define DIAL_PLANE_BIT(plane) (1 << (plane))
+#define DIAL_PLANES_ALL ((1 << DIAL_PLANE_COUNT) - 1)
+
+// Everything the draw code needs to know about where things go. It only
+// depends on the bounds and the font, so it is computed again only when
+// one of them changes instead of on every frame. Without a font the label
+// boxes are not computed.
+typedef struct {
+  GRect bounds;
+  GPoint center;
+  GRect dial_frame;
+  int16_t dial_inset;
+  int16_t hour_circle_radius;
+  bool use_tables;
+  // ring frames, which also set the hand lengths
+  GRect ring_frames[DIAL_RING_COUNT];
+  // minute labels from 5 to 60, hour labels from 1 to 12
+  GRect minute_label_boxes[DIAL_LABEL_COUNT];
+  GRect hour_label_boxes[DIAL_LABEL_COUNT];
+  GRect date_box;
+  GRect date_bg;
+} DialLayout;
+
+void dial_layout_update(DialLayout *layout, GRect bounds, GFont font, bool square_font);
+void dial_layout_scale(DialLayout *layout, const DialLayout *from, GRect bounds);
+GPoint dial_layout_point(const DialLayout *layout, DialRing ring, int32_t angle);
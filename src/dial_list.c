@@ -0,0 +1,232 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "dial_list.h"
+#include "dial_cache.h"
+#include "render_stats.h"
+#include <string.h>
+
+#if DIAL_CACHE_STRATEGY == DIAL_CACHE_LIST
+#define DIAL_LIST_SIZE 640
+#else
+#define DIAL_LIST_SIZE 1
+#endif
+
+// Coordinates and sizes take a byte each, coordinates shifted so that
+// boxes may start a little off screen. Anything out of range drops the
+// list and the dial keeps being drawn from scratch.
+#define DIAL_LIST_BIAS 16
+#define DIAL_LIST_TEXT_MAX 4
+
+typedef enum {
+  DIAL_OP_FILL_COLOR,   // color
+  DIAL_OP_STROKE,       // color, width
+  DIAL_OP_FILL_RECT,    // rect
+  DIAL_OP_FILL_RADIAL,  // rect, inset
+  DIAL_OP_LINE,         // from, to
+  DIAL_OP_CIRCLE,       // center, radius
+  DIAL_OP_TEXT,         // color, box, length, characters
+} DialOp;
+
+static uint8_t s_list[DIAL_LIST_SIZE];
+static uint16_t s_length;
+static bool s_recording;
+static bool s_valid;
+static GRect s_bounds;
+static DialListTextProc s_text_proc;
+// graphics state last recorded, -1 when nothing was recorded yet
+static int16_t s_fill;
+static int32_t s_stroke;
+
+static void prv_put(int value) {
+  if (!s_recording) {
+    return;
+  }
+  if (s_length == DIAL_LIST_SIZE || value < 0 || value > UINT8_MAX) {
+    s_recording = false;
+    return;
+  }
+  s_list[s_length++] = value;
+}
+
+static void prv_put_point(GPoint point) {
+  prv_put(point.x + DIAL_LIST_BIAS);
+  prv_put(point.y + DIAL_LIST_BIAS);
+}
+
+static void prv_put_rect(GRect rect) {
+  prv_put_point(rect.origin);
+  prv_put(rect.size.w);
+  prv_put(rect.size.h);
+}
+
+static GPoint prv_get_point(const uint8_t **at) {
+  GPoint point = GPoint((*at)[0] - DIAL_LIST_BIAS, (*at)[1] - DIAL_LIST_BIAS);
+  *at += 2;
+  return point;
+}
+
+static GRect prv_get_rect(const uint8_t **at) {
+  GPoint origin = prv_get_point(at);
+  GRect rect = (GRect) { .origin = origin, .size = GSize((*at)[0], (*at)[1]) };
+  *at += 2;
+  return rect;
+}
+
+static GColor prv_get_color(const uint8_t **at) {
+  return (GColor8) { .argb = *(*at)++ };
+}
+
+static void prv_set_fill(GContext *ctx, GColor color) {
+  graphics_context_set_fill_color(ctx, color);
+  if (s_recording && s_fill != color.argb) {
+    s_fill = color.argb;
+    prv_put(DIAL_OP_FILL_COLOR);
+    prv_put(color.argb);
+  }
+}
+
+static void prv_set_stroke(GContext *ctx, uint8_t width, GColor color) {
+  graphics_context_set_stroke_color(ctx, color);
+  graphics_context_set_stroke_width(ctx, width);
+  if (s_recording && s_stroke != (color.argb << 8 | width)) {
+    s_stroke = color.argb << 8 | width;
+    prv_put(DIAL_OP_STROKE);
+    prv_put(color.argb);
+    prv_put(width);
+  }
+}
+
+void dial_list_invalidate(void) {
+  s_valid = false;
+}
+
+bool dial_list_replay(GContext *ctx, GRect bounds) {
+  if (!s_valid || !grect_equal(&bounds, &s_bounds)) {
+    return false;
+  }
+  const uint8_t *at = s_list;
+  const uint8_t *const end = s_list + s_length;
+  while (at < end) {
+    const DialOp op = *at++;
+    switch (op) {
+      case DIAL_OP_FILL_COLOR:
+        graphics_context_set_fill_color(ctx, prv_get_color(&at));
+        break;
+      case DIAL_OP_STROKE:
+        graphics_context_set_stroke_color(ctx, prv_get_color(&at));
+        graphics_context_set_stroke_width(ctx, *at++);
+        break;
+      case DIAL_OP_FILL_RECT:
+        graphics_fill_rect(ctx, prv_get_rect(&at), 0, GCornerNone);
+        break;
+      case DIAL_OP_FILL_RADIAL: {
+        GRect frame = prv_get_rect(&at);
+        graphics_fill_radial(ctx, frame, GOvalScaleModeFitCircle, *at++, 0, TRIG_MAX_ANGLE);
+        break;
+      }
+      case DIAL_OP_LINE: {
+        GPoint from = prv_get_point(&at);
+        graphics_draw_line(ctx, from, prv_get_point(&at));
+        break;
+      }
+      case DIAL_OP_CIRCLE: {
+        GPoint center = prv_get_point(&at);
+        graphics_draw_circle(ctx, center, *at++);
+        break;
+      }
+      case DIAL_OP_TEXT: {
+        GColor color = prv_get_color(&at);
+        GRect box = prv_get_rect(&at);
+        char text[DIAL_LIST_TEXT_MAX + 1];
+        const uint8_t length = *at++;
+        memcpy(text, at, length);
+        text[length] = '\0';
+        at += length;
+        s_text_proc(ctx, text, box, color);
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+void dial_list_begin(GRect bounds, DialListTextProc text_proc, bool record) {
+  s_text_proc = text_proc;
+  s_valid = false;
+  s_recording = record && DIAL_CACHE_STRATEGY == DIAL_CACHE_LIST;
+  s_length = 0;
+  s_bounds = bounds;
+  s_fill = -1;
+  s_stroke = -1;
+}
+
+void dial_list_end(void) {
+  s_valid = s_recording;
+  s_recording = false;
+}
+
+void dial_list_fill_rect(GContext *ctx, GRect rect, GColor color) {
+  prv_set_fill(ctx, color);
+  graphics_fill_rect(ctx, rect, 0, GCornerNone);
+  prv_put(DIAL_OP_FILL_RECT);
+  prv_put_rect(rect);
+}
+
+void dial_list_fill_radial(GContext *ctx, GRect frame, uint16_t inset, GColor color) {
+  prv_set_fill(ctx, color);
+  graphics_fill_radial(ctx, frame, GOvalScaleModeFitCircle, inset, 0, TRIG_MAX_ANGLE);
+  prv_put(DIAL_OP_FILL_RADIAL);
+  prv_put_rect(frame);
+  prv_put(inset);
+}
+
+void dial_list_line(GContext *ctx, GPoint from, GPoint to, uint8_t width, GColor color) {
+  prv_set_stroke(ctx, width, color);
+  graphics_draw_line(ctx, from, to);
+  prv_put(DIAL_OP_LINE);
+  prv_put_point(from);
+  prv_put_point(to);
+}
+
+void dial_list_circle(GContext *ctx, GPoint center, uint16_t radius, uint8_t width,
+                      GColor color) {
+  prv_set_stroke(ctx, width, color);
+  graphics_draw_circle(ctx, center, radius);
+  prv_put(DIAL_OP_CIRCLE);
+  prv_put_point(center);
+  prv_put(radius);
+}
+
+void dial_list_text(GContext *ctx, const char *text, GRect box, GColor color) {
+  s_text_proc(ctx, text, box, color);
+  const size_t length = strlen(text);
+  if (length > DIAL_LIST_TEXT_MAX) {
+    s_recording = false;
+    return;
+  }
+  prv_put(DIAL_OP_TEXT);
+  prv_put(color.argb);
+  prv_put_rect(box);
+  prv_put(length);
+  for (size_t i = 0; i < length; i++) {
+    prv_put(text[i]);
+  }
+}
@@ -0,0 +1,41 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <pebble.h>
+
+// Display list of the static dial: while the dial is drawn from scratch,
+// every primitive is recorded with its resolved points, boxes, colors and
+// stroke widths into a buffer of a few hundred bytes. Later frames replay
+// it with no geometry, formatting or text layout work, until config or
+// bounds changes. Only recorded with DIAL_CACHE_LIST, the primitives are
+// drawn either way.
+
+typedef void (*DialListTextProc)(GContext *ctx, const char *text, GRect box, GColor color);
+
+void dial_list_invalidate(void);
+bool dial_list_replay(GContext *ctx, GRect bounds);
+void dial_list_begin(GRect bounds, DialListTextProc text_proc, bool record);
+void dial_list_end(void);
+void dial_list_fill_rect(GContext *ctx, GRect rect, GColor color);
+void dial_list_fill_radial(GContext *ctx, GRect frame, uint16_t inset, GColor color);
+void dial_list_line(GContext *ctx, GPoint from, GPoint to, uint8_t width, GColor color);
+void dial_list_circle(GContext *ctx, GPoint center, uint16_t radius, uint8_t width,
+                      GColor color);
+void dial_list_text(GContext *ctx, const char *text, GRect box, GColor color);
@@ -0,0 +1,205 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "digit_atlas.h"
+#include "render_stats.h"
+#include <pebble.h>
+#include "memory_stats.h"
+
+// Text is antialiased on color displays, so each pixel keeps its coverage,
+// 0 to 3 like a GColor8 channel, in two bits of a 1-bit bitmap twice as
+// wide. 1-bit displays draw text without it and keep one bit per pixel.
+#define COVERAGE_BITS PBL_IF_COLOR_ELSE(2, 1)
+#define COVERAGE_FULL ((1 << COVERAGE_BITS) - 1)
+
+typedef struct {
+  uint8_t x;
+  uint8_t width;
+} DigitGlyph;
+
+static GBitmap *s_atlas;
+static DigitGlyph s_glyphs[10];
+static int16_t s_height;
+
+bool digit_atlas_ready(void) {
+  return s_atlas != NULL;
+}
+
+static int prv_get_coverage(const uint8_t *data, int x) {
+  const int bit = x * COVERAGE_BITS;
+  return (data[bit / 8] >> (bit % 8)) & COVERAGE_FULL;
+}
+
+static void prv_set_coverage(uint8_t *data, int x, int coverage) {
+  const int bit = x * COVERAGE_BITS;
+  data[bit / 8] |= coverage << (bit % 8);
+}
+
+// How much of a pixel the white text covered over the black background:
+// AA edges are shades of gray, so any channel gives the coverage.
+static int prv_captured_coverage(GBitmapFormat format, GBitmapDataRowInfo row, int x) {
+  if (format == GBitmapFormat1Bit) {
+    return (row.data[x / 8] >> (x % 8)) & 1;
+  }
+  return ((GColor8) { .argb = row.data[x] }).g;
+}
+
+static uint8_t prv_blend_channel(int color, int background, int coverage) {
+  return (color * coverage + background * (COVERAGE_FULL - coverage)) / COVERAGE_FULL;
+}
+
+// Writes the color over the pixel at the given coverage, the way the text
+// engine blends antialiased glyphs with what is under them.
+static void prv_set_pixel(GBitmapFormat format, GBitmapDataRowInfo row, int x, GColor color,
+                          int coverage) {
+  if (format == GBitmapFormat1Bit) {
+    if (gcolor_equal(color, GColorBlack)) {
+      row.data[x / 8] &= ~(1 << (x % 8));
+    }
+    else {
+      row.data[x / 8] |= 1 << (x % 8);
+    }
+  }
+  else if (coverage == COVERAGE_FULL) {
+    row.data[x] = color.argb;
+  }
+  else {
+    const GColor8 background = (GColor8) { .argb = row.data[x] };
+    row.data[x] = ((GColor8) {
+      .a = 3,
+      .r = prv_blend_channel(color.r, background.r, coverage),
+      .g = prv_blend_channel(color.g, background.g, coverage),
+      .b = prv_blend_channel(color.b, background.b, coverage)
+    }).argb;
+  }
+}
+
+static GBitmapFormat prv_format(GBitmap *frame_buffer) {
+  return gbitmap_get_format(frame_buffer) == GBitmapFormat1Bit
+         ? GBitmapFormat1Bit : GBitmapFormat8Bit;
+}
+
+// Digits are drawn white on black in the middle of the screen, which is
+// visible on every display shape, and read back from the frame buffer.
+void digit_atlas_build(GContext *ctx, GFont font, GRect bounds) {
+  digit_atlas_destroy();
+  char digit[2] = "0";
+  int width = 0;
+  int height = 0;
+  for (int i = 0; i < 10; i++) {
+    digit[0] = '0' + i;
+    GSize size = graphics_text_layout_get_content_size(digit, font, bounds,
+                                                       GTextOverflowModeFill,
+                                                       GTextAlignmentLeft);
+    s_glyphs[i] = (DigitGlyph) { .x = width, .width = size.w };
+    width += size.w;
+    height = size.h > height ? size.h : height;
+  }
+  if (width == 0 || height == 0 || width > bounds.size.w || height > bounds.size.h) {
+    return;
+  }
+  GPoint origin = GPoint(bounds.origin.x + (bounds.size.w - width) / 2,
+                         bounds.origin.y + (bounds.size.h - height) / 2);
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  graphics_fill_rect(ctx, (GRect) { .origin = origin, .size = GSize(width, height) }, 0,
+                     GCornerNone);
+  graphics_context_set_text_color(ctx, GColorWhite);
+  for (int i = 0; i < 10; i++) {
+    digit[0] = '0' + i;
+    GRect box = GRect(origin.x + s_glyphs[i].x, origin.y, s_glyphs[i].width, height);
+    graphics_draw_text(ctx, digit, font, box, GTextOverflowModeFill, GTextAlignmentLeft, NULL);
+  }
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (!frame_buffer) {
+    return;
+  }
+  GBitmapFormat format = prv_format(frame_buffer);
+  s_atlas = gbitmap_create_blank(GSize(width * COVERAGE_BITS, height), GBitmapFormat1Bit);
+  if (s_atlas) {
+    uint8_t *data = gbitmap_get_data(s_atlas);
+    uint16_t bytes_per_row = gbitmap_get_bytes_per_row(s_atlas);
+    for (int y = 0; y < height; y++) {
+      GBitmapDataRowInfo row = gbitmap_get_data_row_info(frame_buffer, origin.y + y);
+      uint8_t *to = &data[y * bytes_per_row];
+      for (int x = 0; x < width; x++) {
+        int screen_x = origin.x + x;
+        if (screen_x >= row.min_x && screen_x <= row.max_x) {
+          prv_set_coverage(to, x, prv_captured_coverage(format, row, screen_x));
+        }
+      }
+    }
+    s_height = height;
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+}
+
+// Draws the digits centered in the box like GTextAlignmentCenter would,
+// clipped to the given area since the frame buffer is written directly.
+bool digit_atlas_draw_text(GContext *ctx, const char *text, GRect box, GColor color,
+                           GRect clip) {
+  if (!s_atlas) {
+    return false;
+  }
+  int width = 0;
+  for (const char *c = text; *c; c++) {
+    if (*c < '0' || *c > '9') {
+      return false;
+    }
+    width += s_glyphs[*c - '0'].width;
+  }
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (!frame_buffer) {
+    return false;
+  }
+  GBitmapFormat format = prv_format(frame_buffer);
+  const uint8_t *data = gbitmap_get_data(s_atlas);
+  uint16_t bytes_per_row = gbitmap_get_bytes_per_row(s_atlas);
+  int x0 = box.origin.x + (box.size.w - width) / 2;
+  int y0 = box.origin.y > clip.origin.y ? box.origin.y : clip.origin.y;
+  int y1 = box.origin.y + s_height < clip.origin.y + clip.size.h
+           ? box.origin.y + s_height : clip.origin.y + clip.size.h;
+  for (int y = y0; y < y1; y++) {
+    GBitmapDataRowInfo row = gbitmap_get_data_row_info(frame_buffer, y);
+    int min_x = row.min_x > clip.origin.x ? row.min_x : clip.origin.x;
+    int max_x = row.max_x < clip.origin.x + clip.size.w - 1
+                ? row.max_x : clip.origin.x + clip.size.w - 1;
+    const uint8_t *from = &data[(y - box.origin.y) * bytes_per_row];
+    int x = x0;
+    for (const char *c = text; *c; c++) {
+      const DigitGlyph glyph = s_glyphs[*c - '0'];
+      for (int gx = 0; gx < glyph.width; gx++) {
+        const int coverage = prv_get_coverage(from, glyph.x + gx);
+        if (x + gx >= min_x && x + gx <= max_x && coverage) {
+          prv_set_pixel(format, row, x + gx, color, coverage);
+        }
+      }
+      x += glyph.width;
+    }
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+  return true;
+}
+
+void digit_atlas_destroy(void) {
+  if (s_atlas) {
+    gbitmap_destroy(s_atlas);
+    s_atlas = NULL;
+  }
+}
@@ -0,0 +1,34 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <pebble.h>
+
+// The custom fonts only have digits. They are rasterized once per font
+// into a coverage mask, so labels and the date are blended straight into
+// the frame buffer instead of going through the text engine on every
+// frame.
+// Building needs a frame that is repainted afterwards, since the digits
+// are drawn on screen to be captured.
+
+bool digit_atlas_ready(void);
+void digit_atlas_build(GContext *ctx, GFont font, GRect bounds);
+bool digit_atlas_draw_text(GContext *ctx, const char *text, GRect box, GColor color,
+                           GRect clip);
+void digit_atlas_destroy(void);
@@ -0,0 +1,415 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "hand_raster.h"
+#include "render_stats.h"
+#include <pebble.h>
+
+typedef struct {
+  int16_t min_x;
+  int16_t max_x;
+} Span;
+
+// What a stroke's spans need that does not change from row to row, for
+// the given width
+typedef struct {
+  const HandStroke *stroke;
+  int16_t width;
+  int32_t dx;
+  int32_t dy;
+  int32_t len2;
+  // half the width times the length, see prv_stroke_span
+  int32_t reach;
+} StrokeSetup;
+
+static int32_t prv_isqrt(int32_t value) {
+  if (value <= 0) {
+    return 0;
+  }
+  uint32_t root = 0;
+  uint32_t bit = 1u << 30;
+  uint32_t rest = value;
+  while (bit > rest) {
+    bit >>= 2;
+  }
+  while (bit) {
+    if (rest >= root + bit) {
+      rest -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+static int32_t prv_floor_div(int32_t num, int32_t den) {
+  int32_t q = num / den;
+  return (num % den != 0 && (num < 0) != (den < 0)) ? q - 1 : q;
+}
+
+static int32_t prv_ceil_div(int32_t num, int32_t den) {
+  int32_t q = num / den;
+  return (num % den != 0 && (num < 0) == (den < 0)) ? q + 1 : q;
+}
+
+static void prv_span_union(Span *span, int32_t min_x, int32_t max_x) {
+  if (min_x > max_x) {
+    return;
+  }
+  if (span->min_x > span->max_x) {
+    span->min_x = min_x;
+    span->max_x = max_x;
+    return;
+  }
+  if (min_x < span->min_x) span->min_x = min_x;
+  if (max_x > span->max_x) span->max_x = max_x;
+}
+
+// Solves low <= a * coef <= high for the integer a.
+static bool prv_solve(int32_t coef, int32_t low, int32_t high, int32_t *min_a, int32_t *max_a) {
+  if (coef == 0) {
+    return low <= 0 && high >= 0;
+  }
+  if (coef < 0) {
+    int32_t swap = low;
+    low = -high;
+    high = -swap;
+    coef = -coef;
+  }
+  int32_t from = prv_ceil_div(low, coef);
+  int32_t to = prv_floor_div(high, coef);
+  if (from > *min_a) *min_a = from;
+  if (to < *max_a) *max_a = to;
+  return true;
+}
+
+static void prv_dot_span(Span *span, GPoint center, int width, int y) {
+  int32_t dy = y - center.y;
+  int32_t rest = width * width - 4 * dy * dy;
+  if (rest < 0) {
+    return;
+  }
+  int32_t dx = prv_isqrt(rest / 4);
+  prv_span_union(span, center.x - dx, center.x + dx);
+}
+
+static StrokeSetup prv_stroke_setup(const HandStroke *stroke, int width) {
+  StrokeSetup setup = {
+    .stroke = stroke,
+    .width = width,
+    .dx = stroke->to.x - stroke->from.x,
+    .dy = stroke->to.y - stroke->from.y,
+  };
+  setup.len2 = setup.dx * setup.dx + setup.dy * setup.dy;
+  setup.reach = prv_isqrt(width * width * setup.len2 / 4);
+  return setup;
+}
+
+// Pixels whose center is at most width / 2 away from the segment, with the
+// width of the setup. A
+// stroke is convex, so on each row they form a single span: the union of
+// the two end caps and the band along the segment.
+static Span prv_stroke_span(const StrokeSetup *setup, int y) {
+  const HandStroke *stroke = setup->stroke;
+  Span span = { .min_x = 1, .max_x = 0 };
+  prv_dot_span(&span, stroke->from, setup->width, y);
+  if (setup->len2 == 0) {
+    return span;
+  }
+  prv_dot_span(&span, stroke->to, setup->width, y);
+  // with a = x - from.x and b = y - from.y, the band is
+  // |a * dy - b * dx| <= width / 2 * |d| and 0 <= a * dx + b * dy <= |d|^2
+  const int32_t b = y - stroke->from.y;
+  const int32_t dx = setup->dx;
+  const int32_t dy = setup->dy;
+  int32_t min_a = INT16_MIN;
+  int32_t max_a = INT16_MAX;
+  if (prv_solve(dy, b * dx - setup->reach, b * dx + setup->reach, &min_a, &max_a) &&
+      prv_solve(dx, -b * dy, setup->len2 - b * dy, &min_a, &max_a)) {
+    prv_span_union(&span, stroke->from.x + min_a, stroke->from.x + max_a);
+  }
+  return span;
+}
+
+static GRect prv_strokes_box(const HandStroke *strokes, int count) {
+  int16_t x0 = INT16_MAX, y0 = INT16_MAX, x1 = INT16_MIN, y1 = INT16_MIN;
+  for (int i = 0; i < count; i++) {
+    const HandStroke *stroke = &strokes[i];
+    int16_t reach = stroke->width / 2 + 1;
+    int16_t min_x = stroke->from.x < stroke->to.x ? stroke->from.x : stroke->to.x;
+    int16_t max_x = stroke->from.x > stroke->to.x ? stroke->from.x : stroke->to.x;
+    int16_t min_y = stroke->from.y < stroke->to.y ? stroke->from.y : stroke->to.y;
+    int16_t max_y = stroke->from.y > stroke->to.y ? stroke->from.y : stroke->to.y;
+    if (min_x - reach < x0) x0 = min_x - reach;
+    if (max_x + reach > x1) x1 = max_x + reach;
+    if (min_y - reach < y0) y0 = min_y - reach;
+    if (max_y + reach > y1) y1 = max_y + reach;
+  }
+  return GRect(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+}
+
+static void prv_fill_row_1bit(uint8_t *data, int min_x, int max_x, GColor color) {
+  const bool white = !gcolor_equal(color, GColorBlack);
+  for (int x = min_x; x <= max_x; x++) {
+    if (white) {
+      data[x / 8] |= 1 << (x % 8);
+    }
+    else {
+      data[x / 8] &= ~(1 << (x % 8));
+    }
+  }
+}
+
+static void prv_fill_row_8bit(uint8_t *data, int min_x, int max_x, GColor color) {
+  memset(&data[min_x], color.argb, max_x - min_x + 1);
+}
+
+// How much of the pixel the stroke covers, 0 to 3 like a GColor8 channel,
+// from the distance d of its center to the segment and half the width r:
+// 3 up to r - 1/3, 2 up to r, 1 up to r + 1/3. Distances are compared in
+// sixths of a pixel and squared, so there is no square root.
+static int prv_coverage(const StrokeSetup *setup, int x, int y) {
+  const HandStroke *stroke = setup->stroke;
+  const int32_t a = x - stroke->from.x;
+  const int32_t b = y - stroke->from.y;
+  const int32_t along = a * setup->dx + b * setup->dy;
+  // d^2 is distance2 / scale
+  int64_t distance2;
+  int64_t scale = 1;
+  if (setup->len2 == 0 || along <= 0) {
+    distance2 = a * a + b * b;
+  }
+  else if (along >= setup->len2) {
+    const int32_t ex = x - stroke->to.x;
+    const int32_t ey = y - stroke->to.y;
+    distance2 = ex * ex + ey * ey;
+  }
+  else {
+    const int64_t across = a * setup->dy - b * setup->dx;
+    distance2 = across * across;
+    scale = setup->len2;
+  }
+  int coverage = 0;
+  for (int step = -2; step <= 2; step += 2) {
+    const int64_t threshold = 3 * stroke->width + step;
+    if (threshold > 0 && 36 * distance2 <= threshold * threshold * scale) {
+      coverage++;
+    }
+  }
+  return coverage;
+}
+
+static uint8_t prv_blend_channel(int color, int background, int coverage) {
+  return (color * coverage + background * (3 - coverage)) / 3;
+}
+
+static GColor prv_blend(GColor color, GColor background, int coverage) {
+  return (GColor) {
+    .a = 3,
+    .r = prv_blend_channel(color.r, background.r, coverage),
+    .g = prv_blend_channel(color.g, background.g, coverage),
+    .b = prv_blend_channel(color.b, background.b, coverage)
+  };
+}
+
+static bool prv_span_contains(const Span *span, int x) {
+  return span->min_x <= x && x <= span->max_x;
+}
+
+// Without access to the frame buffer the strokes go through the regular
+// graphics calls.
+static void prv_draw_with_graphics(GContext *ctx, const HandStroke *strokes, int count) {
+  for (int i = 0; i < count; i++) {
+    const HandStroke *stroke = &strokes[i];
+    if (gpoint_equal(&stroke->from, &stroke->to)) {
+      graphics_context_set_fill_color(ctx, stroke->color);
+      graphics_fill_circle(ctx, stroke->from, stroke->width / 2);
+    }
+    else {
+      graphics_context_set_stroke_color(ctx, stroke->color);
+      graphics_context_set_stroke_width(ctx, stroke->width);
+      graphics_draw_line(ctx, stroke->from, stroke->to);
+    }
+  }
+}
+
+typedef void (*FillRow)(uint8_t *data, int min_x, int max_x, GColor color);
+
+// Writes the part of min_x..max_x that no stroke above has covered yet.
+// Covered spans are few and may overlap, so the gaps are found by walking
+// past whichever covered span holds x.
+static void prv_fill_uncovered(FillRow fill_row, uint8_t *data, int min_x, int max_x,
+                               GColor color, const Span *covered, int covered_count) {
+  int x = min_x;
+  while (x <= max_x) {
+    int gap_end = max_x;
+    bool inside = false;
+    for (int i = 0; i < covered_count; i++) {
+      if (covered[i].min_x <= x && x <= covered[i].max_x) {
+        x = covered[i].max_x + 1;
+        inside = true;
+        break;
+      }
+      if (covered[i].min_x > x && covered[i].min_x - 1 < gap_end) {
+        gap_end = covered[i].min_x - 1;
+      }
+    }
+    if (!inside) {
+      fill_row(data, x, gap_end, color);
+      x = gap_end + 1;
+    }
+  }
+}
+
+static Span prv_clip_span(Span span, int min_x, int max_x) {
+  return (Span) {
+    .min_x = span.min_x > min_x ? span.min_x : min_x,
+    .max_x = span.max_x < max_x ? span.max_x : max_x
+  };
+}
+
+// The final color of an edge pixel whose topmost stroke is the given one:
+// the strokes up to it blended in order over what is in the frame buffer.
+static GColor prv_compose(const StrokeSetup *setups, const Span *inner, const Span *outer,
+                          int top, GColor background, int x, int y) {
+  GColor color = background;
+  for (int i = 0; i <= top; i++) {
+    if (prv_span_contains(&inner[i], x)) {
+      color = setups[i].stroke->color;
+    }
+    else if (prv_span_contains(&outer[i], x)) {
+      const int coverage = prv_coverage(&setups[i], x, y);
+      if (coverage) {
+        color = prv_blend(setups[i].stroke->color, color, coverage);
+      }
+    }
+  }
+  return color;
+}
+
+static void prv_compose_range(uint8_t *data, const StrokeSetup *setups, const Span *inner,
+                              const Span *outer, int count, int top, int min_x, int max_x,
+                              int y) {
+  for (int x = min_x; x <= max_x; x++) {
+    bool hidden = false;
+    for (int i = top + 1; i < count && !hidden; i++) {
+      hidden = prv_span_contains(&outer[i], x);
+    }
+    if (!hidden) {
+      const GColor background = (GColor) { .argb = data[x] };
+      data[x] = prv_compose(setups, inner, outer, top, background, x, y).argb;
+    }
+  }
+}
+
+// Pixels within width / 2 - 1/2 of a stroke are fully covered and filled
+// like unblended strokes, topmost first, leaving out those that a stroke
+// above reaches at all. What is left within width / 2 + 1/2 are edges: each
+// is blended once, by the topmost stroke reaching it, through all the
+// strokes below.
+static void prv_draw_row_antialiased(GBitmapDataRowInfo row, const StrokeSetup *inner_setups,
+                                     const StrokeSetup *outer_setups, int count, int y,
+                                     int row_min_x, int row_max_x) {
+  Span inner[HAND_RASTER_MAX_STROKES];
+  Span outer[HAND_RASTER_MAX_STROKES];
+  Span covered[HAND_RASTER_MAX_STROKES];
+  int covered_count = 0;
+  for (int i = count - 1; i >= 0; i--) {
+    inner[i] = prv_clip_span(prv_stroke_span(&inner_setups[i], y), row_min_x, row_max_x);
+    outer[i] = prv_clip_span(prv_stroke_span(&outer_setups[i], y), row_min_x, row_max_x);
+    if (inner[i].min_x <= inner[i].max_x) {
+      prv_fill_uncovered(prv_fill_row_8bit, row.data, inner[i].min_x, inner[i].max_x,
+                         inner_setups[i].stroke->color, covered, covered_count);
+    }
+    if (outer[i].min_x <= outer[i].max_x) {
+      covered[covered_count++] = outer[i];
+    }
+  }
+  for (int i = count - 1; i >= 0; i--) {
+    if (outer[i].min_x > outer[i].max_x) {
+      continue;
+    }
+    if (inner[i].min_x > inner[i].max_x) {
+      prv_compose_range(row.data, outer_setups, inner, outer, count, i, outer[i].min_x,
+                        outer[i].max_x, y);
+      continue;
+    }
+    prv_compose_range(row.data, outer_setups, inner, outer, count, i, outer[i].min_x,
+                      inner[i].min_x - 1, y);
+    prv_compose_range(row.data, outer_setups, inner, outer, count, i, inner[i].max_x + 1,
+                      outer[i].max_x, y);
+  }
+}
+
+void hand_raster_draw(GContext *ctx, const HandStroke *strokes, int count, GRect clip,
+                      bool antialiased) {
+  if (count > HAND_RASTER_MAX_STROKES) {
+    count = HAND_RASTER_MAX_STROKES;
+  }
+  GRect box = prv_strokes_box(strokes, count);
+  grect_clip(&box, &clip);
+  if (box.size.w <= 0 || box.size.h <= 0) {
+    return;
+  }
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (!frame_buffer) {
+    prv_draw_with_graphics(ctx, strokes, count);
+    return;
+  }
+  // only GColor8 pixels can be blended
+  const bool one_bit = gbitmap_get_format(frame_buffer) == GBitmapFormat1Bit;
+  antialiased = antialiased && !one_bit;
+  const FillRow fill_row = one_bit ? prv_fill_row_1bit : prv_fill_row_8bit;
+  StrokeSetup setups[HAND_RASTER_MAX_STROKES];
+  StrokeSetup outer_setups[HAND_RASTER_MAX_STROKES];
+  for (int i = 0; i < count; i++) {
+    const int width = strokes[i].width;
+    setups[i] = prv_stroke_setup(&strokes[i], antialiased && width > 0 ? width - 1 : width);
+    if (antialiased) {
+      outer_setups[i] = prv_stroke_setup(&strokes[i], width + 1);
+    }
+  }
+  const int box_max_x = box.origin.x + box.size.w - 1;
+  for (int y = box.origin.y; y < box.origin.y + box.size.h; y++) {
+    GBitmapDataRowInfo row = gbitmap_get_data_row_info(frame_buffer, y);
+    // round displays only have part of each row
+    int row_min_x = row.min_x > box.origin.x ? row.min_x : box.origin.x;
+    int row_max_x = row.max_x < box_max_x ? row.max_x : box_max_x;
+    if (antialiased) {
+      prv_draw_row_antialiased(row, setups, outer_setups, count, y, row_min_x, row_max_x);
+      continue;
+    }
+    // topmost stroke first, each pixel is written once with its final color
+    Span covered[HAND_RASTER_MAX_STROKES];
+    int covered_count = 0;
+    for (int i = count - 1; i >= 0; i--) {
+      Span span = prv_clip_span(prv_stroke_span(&setups[i], y), row_min_x, row_max_x);
+      if (span.min_x <= span.max_x) {
+        prv_fill_uncovered(fill_row, row.data, span.min_x, span.max_x, strokes[i].color,
+                           covered, covered_count);
+        covered[covered_count++] = span;
+      }
+    }
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+}
@@ -0,0 +1,45 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <pebble.h>
+
+// Hands are made of round capped strokes painted on top of each other. The
+// rasterizer walks the rows the hand covers once and writes each pixel once,
+// with the color of the topmost stroke covering it, straight into the frame
+// buffer, instead of drawing each stroke and cap as a separate primitive
+// over the same pixels. On color displays edges can be antialiased: they
+// are blended once, through every stroke under them.
+
+typedef struct {
+  GPoint from;
+  GPoint to;
+  uint8_t width;
+  GColor color;
+} HandStroke;
+
+// a stroke of zero length is a dot, its width is the diameter
+#define HAND_STROKE(from, to, width, color) ((HandStroke) { (from), (to), (width), (color) })
+#define HAND_DOT(center, radius, color) ((HandStroke) { (center), (center), 2 * (radius), (color) })
+
+#define HAND_RASTER_MAX_STROKES 10
+
+// Strokes are painted in order, clipped to the given area.
+void hand_raster_draw(GContext *ctx, const HandStroke *strokes, int count, GRect clip,
+                      bool antialiased);
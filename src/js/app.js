@@ -1,3 +1,82 @@
 var Clay = require('pebble-clay');
 var clayConfig = require('./config.json');
-var clay = new Clay(clayConfig);
+var settingsPayload = require('./settings_payload');
+var clay = new Clay(clayConfig, null, { autoHandleEvents: false });
+
+// Builds with render statistics are known from their hourly dumps, opening
+// the settings asks them for a fresh one.
+var RENDER_STATS_BUILD = 'render-stats-build';
+
+Pebble.addEventListener('showConfiguration', function() {
+  if (localStorage.getItem(RENDER_STATS_BUILD)) {
+    Pebble.sendAppMessage({ render_stats: 1 }, null, function(error) {
+      console.log('Failed to request render stats: ' + JSON.stringify(error));
+    });
+  }
+  Pebble.openURL(clay.generateUrl());
+});
+
+Pebble.addEventListener('webviewclosed', function(e) {
+  if (!e || !e.response) {
+    return;
+  }
+  var settings = clay.getSettings(e.response, false);
+  var values = {};
+  Object.keys(settings).forEach(function(key) {
+    values[key] = Clay.prepareForAppMessage(settings[key]);
+  });
+  // All the settings go to the watch as one byte array of a few dozen
+  // bytes, the watch works out what changed. A watch that lost its
+  // settings, or another watch, gets all of them back.
+  var payload = settingsPayload.pack(clayConfig, values);
+  if (!payload) {
+    return;
+  }
+  Pebble.sendAppMessage({ settings_payload: payload }, null, function(error) {
+    console.log('Failed to send settings: ' + JSON.stringify(error));
+  });
+});
+
+// Render statistics, only answered by builds made with VUELA_RENDER_STATS=1.
+var PLANES = ['marks', 'day', 'clock', 'seconds'];
+
+function readUint(bytes, offset, size) {
+  var value = 0;
+  for (var i = size - 1; i >= 0; i--) {
+    value = value * 256 + bytes[offset + i];
+  }
+  return value;
+}
+
+function logRenderStats(bytes) {
+  var offset = 0;
+  PLANES.forEach(function(plane) {
+    console.log(plane + ': ' + readUint(bytes, offset, 4) + ' redraws, ' +
+                readUint(bytes, offset + 4, 4) + ' draw calls, ' +
+                readUint(bytes, offset + 8, 4) + ' ms');
+    offset += 12;
+  });
+  var ticks = readUint(bytes, offset, 4);
+  var animationFrames = readUint(bytes, offset + 4, 4);
+  var dirtyMarks = readUint(bytes, offset + 8, 4);
+  var redundantDirtyMarks = readUint(bytes, offset + 12, 4);
+  var frames = readUint(bytes, offset + 16, 4);
+  offset += 20;
+  console.log(frames + ' frames, ' + ticks + ' ticks, ' + animationFrames + ' animation frames, ' +
+              redundantDirtyMarks + '/' + dirtyMarks + ' redundant dirty marks');
+  while (offset + 4 * PLANES.length <= bytes.length) {
+    var frame = PLANES.map(function(plane, i) {
+      return plane + ' ' + readUint(bytes, offset + 4 * i, 2) + 'ms/' +
+             readUint(bytes, offset + 4 * i + 2, 2);
+    });
+    console.log('frame: ' + frame.join(', '));
+    offset += 4 * PLANES.length;
+  }
+}
+
+Pebble.addEventListener('appmessage', function(e) {
+  if (e.payload.render_stats) {
+    localStorage.setItem(RENDER_STATS_BUILD, '1');
+    logRenderStats(e.payload.render_stats);
+  }
+});
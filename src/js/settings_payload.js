@@ -0,0 +1,231 @@
+// Packs the Clay settings into the single byte array the watch decodes in
+// one pass (prv_unpack_settings in enamel.c). The layout is derived from
+// config.json the same way enamel derives it on the watch:
+//   version, uint32 mask of the settings sent (bit = setting index),
+//   toggles and checkbox groups as bits, then the other settings sent in
+//   order, little endian: colors as GColor8, string options as their index,
+//   numbers as int16/int32, times as uint32 seconds and text NUL terminated.
+
+function cvarname(name) {
+  return name.replace(/([^\w\s]| )/g, '_');
+}
+
+function settingId(item) {
+  return cvarname(item.id !== undefined ? item.id : item.messageKey);
+}
+
+function flatItems(config) {
+  var items = [];
+  config.forEach(function(item) {
+    if (item.type === 'section') {
+      items = items.concat(flatItems(item.items));
+    } else if (item.messageKey !== undefined && item['enamel-ignore'] === undefined) {
+      items.push(item);
+    }
+  });
+  return items;
+}
+
+function optionArray(item) {
+  var options = [];
+  item.options.forEach(function(option) {
+    options = options.concat(Array.isArray(option.value) ? option.value : [option]);
+  });
+  return options;
+}
+
+function hasStringOptions(item) {
+  return optionArray(item).some(function(option) {
+    return typeof option.value === 'string';
+  });
+}
+
+function hasIntegerOptions(item) {
+  return optionArray(item).every(function(option) {
+    return /^\s*[-+]?\d+\s*$/.test(String(option.value));
+  });
+}
+
+// C type of the setting in the record and the payload, null for bits
+function recordType(item) {
+  switch (item.type) {
+    case 'color':
+      return 'uint8_t';
+    case 'select':
+    case 'radiogroup':
+      return hasStringOptions(item) && !hasIntegerOptions(item) ? 'uint8_t' : 'int16_t';
+    case 'slider':
+      if (item.step !== undefined && String(item.step).indexOf('.') >= 0) {
+        return 'int32_t';
+      }
+      var min = item.min !== undefined ? item.min : 0;
+      var max = item.max !== undefined ? item.max : 100;
+      return min >= -32768 && max <= 32767 ? 'int16_t' : 'int32_t';
+    case 'input':
+      return item.attributes && item.attributes.type === 'time' ? 'uint32_t' : 'char';
+  }
+  return null;
+}
+
+var SIZES = { 'uint8_t': 1, 'int16_t': 2, 'int32_t': 4, 'uint32_t': 4 };
+
+// Same as ENAMEL_RECORD_VERSION, so a watch built from another config.json
+// ignores the payload
+function layoutVersion(items) {
+  var layout = '';
+  items.forEach(function(item) {
+    layout += settingId(item) + ':' + item.type + ':' + (recordType(item) || 'None') + ';';
+    if (item.type === 'checkboxgroup') {
+      layout += item.options.length;
+    }
+  });
+  var crc = 0;
+  for (var i = 0; i < layout.length; i++) {
+    crc = (crc * 31 + layout.charCodeAt(i)) % 65521;
+  }
+  return crc % 255 + 1;
+}
+
+// One entry per setting id, typed after its first item like the watch
+function layout(config) {
+  var items = flatItems(config);
+  var settings = [];
+  var ids = {};
+  var bit = 0;
+  items.forEach(function(item) {
+    var id = settingId(item);
+    if (ids[id]) {
+      return;
+    }
+    ids[id] = true;
+    settings.push({ key: item.messageKey, item: item, type: recordType(item), bit: bit });
+    if (item.type === 'toggle') {
+      bit += 1;
+    } else if (item.type === 'checkboxgroup') {
+      bit += item.options.length;
+    }
+  });
+  // the mask, like ENAMEL_CHANGED_* on the watch, has a bit per setting
+  if (settings.length > 32) {
+    throw new Error('Settings payload supports up to 32 settings, config has ' +
+                    settings.length);
+  }
+  return { version: layoutVersion(items), settings: settings, bits: bit };
+}
+
+function writeUint(bytes, value, size) {
+  for (var i = 0; i < size; i++) {
+    bytes.push(value & 0xff);
+    value = value >> 8;
+  }
+}
+
+// UTF-8 bytes of the text, as many as fit in max without splitting a
+// character. Lone surrogates become U+FFFD like in TextEncoder.
+function utf8Bytes(text, max) {
+  var bytes = [];
+  for (var i = 0; i < text.length; i++) {
+    var code = text.charCodeAt(i);
+    if (code >= 0xd800 && code < 0xdc00 && i + 1 < text.length) {
+      var low = text.charCodeAt(i + 1);
+      if (low >= 0xdc00 && low < 0xe000) {
+        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+        i++;
+      }
+    }
+    if (code >= 0xd800 && code < 0xe000) {
+      code = 0xfffd;
+    }
+    var encoded;
+    if (code < 0x80) {
+      encoded = [code];
+    } else if (code < 0x800) {
+      encoded = [0xc0 | code >> 6, 0x80 | code & 0x3f];
+    } else if (code < 0x10000) {
+      encoded = [0xe0 | code >> 12, 0x80 | code >> 6 & 0x3f, 0x80 | code & 0x3f];
+    } else {
+      encoded = [0xf0 | code >> 18, 0x80 | code >> 12 & 0x3f, 0x80 | code >> 6 & 0x3f,
+                 0x80 | code & 0x3f];
+    }
+    if (bytes.length + encoded.length > max) {
+      break;
+    }
+    bytes = bytes.concat(encoded);
+  }
+  return bytes;
+}
+
+function colorByte(value) {
+  var rgb = typeof value === 'string' ? parseInt(value.replace(/^(#|0x)/, ''), 16) : value;
+  return 0xc0 | ((rgb >> 22) & 0x3) << 4 | ((rgb >> 14) & 0x3) << 2 | ((rgb >> 6) & 0x3);
+}
+
+function writeValue(bytes, setting, value) {
+  var item = setting.item;
+  if (item.type === 'color') {
+    bytes.push(colorByte(value));
+  } else if (setting.type === 'uint8_t') {
+    var index = 0;
+    optionArray(item).forEach(function(option, i) {
+      if (option.value === value) {
+        index = i;
+      }
+    });
+    bytes.push(index);
+  } else if (setting.type === 'uint32_t') {
+    var parts = String(value).split(':');
+    var seconds = parseInt(parts[0], 10) * 3600 + parseInt(parts[1], 10) * 60 +
+                  (parts.length > 2 ? parseInt(parts[2], 10) : 0);
+    writeUint(bytes, seconds, 4);
+  } else if (setting.type === 'char') {
+    utf8Bytes(String(value), 99).forEach(function(byte) {
+      bytes.push(byte);
+    });
+    bytes.push(0);
+  } else {
+    writeUint(bytes, parseInt(value, 10), SIZES[setting.type]);
+  }
+}
+
+// Returns the payload with the values (as prepared for AppMessage), or
+// null when there are none.
+function pack(config, values) {
+  var payload = layout(config);
+  var mask = 0;
+  var bits = [];
+  var fields = [];
+  for (var i = 0; i < (payload.bits + 7) >> 3; i++) {
+    bits.push(0);
+  }
+  payload.settings.forEach(function(setting, index) {
+    var value = values[setting.key];
+    if (value === undefined) {
+      return;
+    }
+    mask = (mask | (1 << index)) >>> 0;
+    var flags = setting.item.type === 'toggle' ? [value] :
+                setting.item.type === 'checkboxgroup' ? value : [];
+    flags.forEach(function(flag, offset) {
+      var bit = setting.bit + offset;
+      if (flag) {
+        bits[bit >> 3] |= 1 << (bit & 7);
+      }
+    });
+    if (setting.type) {
+      writeValue(fields, setting, value);
+    }
+  });
+  if (!mask) {
+    return null;
+  }
+  var bytes = [payload.version];
+  writeUint(bytes, mask, 4);
+  return bytes.concat(bits, fields);
+}
+
+module.exports = {
+  version: function(config) {
+    return layout(config).version;
+  },
+  pack: pack
+};
@@ -20,351 +20,616 @@
 
 #include "enamel.h"
 #include "watch_model.h"
+#include "dial_cache.h"
+#include "dial_list.h"
+#include "dial_layout.h"
+#include "digit_atlas.h"
+#include "hand_raster.h"
+#include "clock_angles.h"
+#include "render_stats.h"
 #include <pebble-events/pebble-events.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include "memory_stats.h"
 
 static Window *window;
-static Layer *clock_layer;
-static Layer *seconds_layer;
-static Layer *marks_layer;
-static Layer *day_layer;
+static Layer *compositor_layer;
 ClockState clock_state;
 GFont digital_font;
+static DialLayout s_layout;
+static uint8_t s_dirty_planes;
+static bool s_area_changing;
+static GRect s_canvas_bounds;
+static GRect s_damage;
+static bool s_damage_pending;
+static bool s_damage_is_full;
+
+// A cold start is staged so the time shows as soon as possible: the first
+// frame only draws the ticks and the hands, the font and the complete dial
+// come on the next turn of the event loop and the intro after that.
+typedef enum {
+  STARTUP_FIRST_FRAME,
+  STARTUP_LOAD_DIAL,
+  STARTUP_DIAL,
+  STARTUP_START_MODEL,
+  STARTUP_DONE,
+} StartupStage;
+
+static StartupStage s_startup_stage;
+static AppTimer *s_startup_timer;
+static bool s_focused;
+
+static void prv_startup_frame_drawn(void);
 
 ResHandle get_font_handle(void) {
-    bool square = strcmp(enamel_get_clock_font(), "SQUARE") == 0;
+    bool square = enamel_get_settings()->clock_font == CLOCK_FONT_SQUARE;
     return resource_get_handle(square ? RESOURCE_ID_SILLYPIXEL_11 : RESOURCE_ID_PIXOLLETTA_10);
 }
 
-bool battery_saver_enabled(int hour) {
-    if (enamel_get_battery_saver_enabled()) {
-        int hours[] = { 19, 20, 21, 22, 23, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
-        int from = atoi(enamel_get_battery_saver_start());
-        int to = atoi(enamel_get_battery_saver_stop());
-        int hour_index  = -1;
-        int i;
-        for (i = from; i <= to; i++) {
-            if (hours[i] == hour) {
-                hour_index = i;
-        	break;
-            }
-        }
-        return (hour_index >= from) && (hour_index < to);
-    }
-    return false;
+static bool font_is_square(void) {
+    return enamel_get_settings()->clock_font == CLOCK_FONT_SQUARE;
 }
 
-void watch_model_handle_clock_change(ClockState state) {
-  //APP_LOG(APP_LOG_LEVEL_DEBUG_VERBOSE, "CLOCK update"); 
-  clock_state = state;
-  layer_mark_dirty(clock_layer);
-  layer_mark_dirty(seconds_layer);
-  layer_mark_dirty(day_layer);
+static void prv_update_layout(void) {
+  GRect bounds = layer_get_unobstructed_bounds(window_get_root_layer(window));
+  dial_layout_update(&s_layout, bounds, digital_font, font_is_square());
+}
+
+// Everything is drawn by compositor_layer, which is clipped to the damaged
+// area. Its bounds are shifted so it keeps drawing in screen coordinates
+// no matter where the damaged area is.
+static void prv_set_damage(GRect damage) {
+  if (s_damage_pending) {
+    int16_t x0 = damage.origin.x < s_damage.origin.x ? damage.origin.x : s_damage.origin.x;
+    int16_t y0 = damage.origin.y < s_damage.origin.y ? damage.origin.y : s_damage.origin.y;
+    int16_t x1 = damage.origin.x + damage.size.w;
+    int16_t y1 = damage.origin.y + damage.size.h;
+    if (s_damage.origin.x + s_damage.size.w > x1) x1 = s_damage.origin.x + s_damage.size.w;
+    if (s_damage.origin.y + s_damage.size.h > y1) y1 = s_damage.origin.y + s_damage.size.h;
+    damage = GRect(x0, y0, x1 - x0, y1 - y0);
+  }
+  grect_clip(&damage, &s_canvas_bounds);
+  s_damage = damage;
+  s_damage_pending = true;
+  s_damage_is_full = grect_equal(&damage, &s_canvas_bounds);
+  layer_set_frame(compositor_layer, damage);
+  layer_set_bounds(compositor_layer, GRect(-damage.origin.x, -damage.origin.y,
+                                           s_canvas_bounds.size.w, s_canvas_bounds.size.h));
+}
+
+// Flags the planes whose content changed and the area they cover.
+static void prv_invalidate(uint8_t planes, GRect damage) {
+  s_dirty_planes |= planes;
+  prv_set_damage(damage);
+  layer_mark_dirty(compositor_layer);
+}
+
+static void prv_invalidate_all(uint8_t planes) {
+  prv_invalidate(planes, s_canvas_bounds);
+}
+
+// Only color displays blend edges, and only at full quality
+static bool prv_antialiased(void) {
+  return PBL_IF_COLOR_ELSE(power_policy_render_quality() == RENDER_QUALITY_FULL, false);
+}
+
+static bool seconds_visible(void) {
+  return watch_model_seconds_enabled();
+}
+
+static GPoint second_hand_tip(const DialLayout *layout, int32_t second_angle) {
+  return dial_layout_point(layout, DIAL_RING_SECOND_HAND, second_angle);
 }
 
-void watch_model_handle_time_change(struct tm *tick_time) {
-  //APP_LOG(APP_LOG_LEVEL_DEBUG_VERBOSE, "MINUTES update");
-  clock_state.minute_angle = tick_time->tm_min * 6;
-  clock_state.hour_angle = tick_time->tm_hour%12 * 30 + clock_state.minute_angle*.08;
-  clock_state.second_angle = tick_time->tm_sec * 6;
-  clock_state.date = tick_time->tm_mday;
-  clock_state.hour = tick_time->tm_hour;
-  layer_mark_dirty(clock_layer);
-  layer_mark_dirty(seconds_layer);
-  layer_mark_dirty(day_layer);
+// Area swept by the seconds hand when moving between two angles: the box
+// around both segments, grown by the outline stroke and the center caps.
+static GRect seconds_damage(const DialLayout *layout, int32_t from_angle, int32_t to_angle) {
+  const int margin = 5;
+  GPoint center_point = layout->center;
+  GPoint from = second_hand_tip(layout, from_angle);
+  GPoint to = second_hand_tip(layout, to_angle);
+  int16_t x0 = center_point.x, x1 = center_point.x;
+  int16_t y0 = center_point.y, y1 = center_point.y;
+  GPoint points[] = { from, to };
+  for (unsigned i = 0; i < ARRAY_LENGTH(points); i++) {
+    if (points[i].x < x0) x0 = points[i].x;
+    if (points[i].x > x1) x1 = points[i].x;
+    if (points[i].y < y0) y0 = points[i].y;
+    if (points[i].y > y1) y1 = points[i].y;
+  }
+  return GRect(x0 - margin, y0 - margin, x1 - x0 + 2*margin + 1, y1 - y0 + 2*margin + 1);
 }
 
-void watch_model_handle_seconds_change(struct tm *tick_time) {
-  //APP_LOG(APP_LOG_LEVEL_DEBUG_VERBOSE, "SECONDS update");
-  clock_state.second_angle = tick_time->tm_sec * 6;
-  layer_mark_dirty(seconds_layer);
+#define HAND_PLANES (DIAL_PLANE_BIT(DIAL_PLANE_DAY) | DIAL_PLANE_BIT(DIAL_PLANE_CLOCK) | \
+                     DIAL_PLANE_BIT(DIAL_PLANE_SECONDS))
+
+// The hour and minute hands cover most of the dial, the seconds hand and
+// the date only repaint the area they touch.
+void watch_model_handle_frame(ClockState state, uint8_t changes) {
+  const ClockState previous_state = clock_state;
+  clock_state = state;
+  if (changes & CLOCK_CHANGE_QUALITY) {
+    dial_cache_invalidate();
+    dial_list_invalidate();
+    prv_invalidate_all(DIAL_PLANES_ALL);
+    return;
+  }
+  if (changes & (CLOCK_CHANGE_HANDS | CLOCK_CHANGE_SECONDS_VISIBLE)) {
+    prv_invalidate_all(HAND_PLANES);
+    return;
+  }
+  if (changes & CLOCK_CHANGE_DATE) {
+    prv_invalidate(DIAL_PLANE_BIT(DIAL_PLANE_DAY), s_layout.date_bg);
+  }
+  if ((changes & CLOCK_CHANGE_SECONDS) && seconds_visible()) {
+    const uint8_t planes = DIAL_PLANE_BIT(DIAL_PLANE_SECONDS);
+    if (!s_area_changing) {
+      prv_invalidate(planes, seconds_damage(&s_layout, previous_state.second_angle,
+                                            state.second_angle));
+    }
+    else {
+      prv_invalidate_all(planes);
+    }
+  }
 }
 
-void watch_model_handle_config_change(void) {
+#define POWER_SETTINGS (ENAMEL_CHANGED_DISPLAY_SECONDS | ENAMEL_CHANGED_SECONDS_BURST | \
+                        ENAMEL_CHANGED_TAP_TO_ANIMATE | \
+                        ENAMEL_CHANGED_BATTERY_SAVER_ENABLED | \
+                        ENAMEL_CHANGED_BATTERY_SAVER_START | ENAMEL_CHANGED_BATTERY_SAVER_STOP)
+#define DIAL_SETTINGS (ENAMEL_CHANGED_SCREEN_COLOR | ENAMEL_CHANGED_CLOCK_BG_COLOR | \
+                       ENAMEL_CHANGED_CLOCK_FG_COLOR | ENAMEL_CHANGED_DRAW_HOUR_CIRCLE | \
+                       ENAMEL_CHANGED_SAVER_QUALITY | ENAMEL_CHANGED_LOW_BATTERY_QUALITY)
+
+// Only the work the changed settings call for is done: the font and the
+// layout, the cached dial, subscriptions or just some planes.
+void watch_model_handle_config_change(uint32_t changed) {
   //APP_LOG(APP_LOG_LEVEL_DEBUG_VERBOSE, "CONFIG update");
-  time_t t = time(NULL);
-  struct tm *now = localtime(&t);
-  update_subscriptions(now->tm_hour);
-  fonts_unload_custom_font(digital_font);
-  digital_font = fonts_load_custom_font(get_font_handle());
-  layer_mark_dirty(clock_layer);
-  layer_mark_dirty(seconds_layer);
-  layer_mark_dirty(day_layer);
+  if (changed & POWER_SETTINGS) {
+    time_t t = time(NULL);
+    struct tm *now = localtime(&t);
+    power_policy_update(now->tm_hour);
+    update_subscriptions();
+  }
+  // before the dial stage of a cold start the font is not loaded yet
+  if ((changed & ENAMEL_CHANGED_CLOCK_FONT) && digital_font) {
+    fonts_unload_custom_font(digital_font);
+    digital_font = fonts_load_custom_font(get_font_handle());
+    digit_atlas_destroy();
+    prv_update_layout();
+  }
+  MEMORY_STATS_SAMPLE("config change");
+  if (changed & (DIAL_SETTINGS | ENAMEL_CHANGED_CLOCK_FONT)) {
+    dial_cache_invalidate();
+    dial_list_invalidate();
+    prv_invalidate_all(DIAL_PLANES_ALL);
+    return;
+  }
+  uint8_t planes = 0;
+  if (changed & (ENAMEL_CHANGED_HOUR_HAND_COLOR | ENAMEL_CHANGED_MINUTE_HAND_COLOR)) {
+    planes |= DIAL_PLANE_BIT(DIAL_PLANE_CLOCK);
+  }
+  if (changed & (ENAMEL_CHANGED_SECOND_HAND_COLOR | ENAMEL_CHANGED_DISPLAY_SECONDS |
+                 ENAMEL_CHANGED_SECONDS_BURST)) {
+    // the clock plane draws the center cap when the seconds hand is off
+    planes |= DIAL_PLANE_BIT(DIAL_PLANE_CLOCK) | DIAL_PLANE_BIT(DIAL_PLANE_SECONDS);
+  }
+  if (planes) {
+    prv_invalidate_all(planes);
+  }
+  else if (changed & ENAMEL_CHANGED_DISPLAY_DATE) {
+    prv_invalidate(DIAL_PLANE_BIT(DIAL_PLANE_DAY), s_layout.date_bg);
+  }
 }
 
-static bool font_is_square(void) {
-    return strcmp(enamel_get_clock_font(), "SQUARE") == 0;
+// Numerals need the font, which the first frame goes without, and are
+// left out at minimal quality.
+static bool prv_numerals_visible(void) {
+  return digital_font && power_policy_render_quality() != RENDER_QUALITY_MINIMAL;
 }
 
-static void draw_day(Layer *layer, GContext *ctx) {
-    if (enamel_get_display_date()) {
-        GRect layer_bounds = layer_get_unobstructed_bounds(layer);
-        int w = layer_bounds.size.w;
-        int h = layer_bounds.size.h;
-        graphics_context_set_fill_color(ctx, enamel_get_clock_fg_color());
-        graphics_context_set_text_color(ctx, enamel_get_clock_bg_color());
+// Digits come from the atlas once it is built, the text engine is only
+// used for the frames before that.
+static void prv_draw_digits(GContext *ctx, const char *text, GRect box, GColor color) {
+  if (!digit_atlas_draw_text(ctx, text, box, color, s_damage)) {
+    graphics_context_set_text_color(ctx, color);
+    graphics_draw_text(ctx, text, digital_font, box, GTextOverflowModeFill,
+                       GTextAlignmentCenter, NULL);
+  }
+}
+
+static void draw_day_proc(GContext *ctx, const DialLayout *layout) {
+    const EnamelSettings *settings = enamel_get_settings();
+    const RenderQuality quality = power_policy_render_quality();
+    if (settings->display_date && prv_numerals_visible()) {
+        graphics_context_set_fill_color(ctx, settings->clock_fg_color);
         static char s_date[3];
         snprintf(s_date, sizeof(s_date), "%d", clock_state.date);
-        GRect text_frame = (GRect) { .size = GSize(w*.66, h*.66) };
-        grect_align(&text_frame, &layer_bounds, GAlignCenter, false);
-	GRect text_box = (GRect) {
-          .size = GSize(16, 15),
-          .origin = gpoint_from_polar(text_frame, GOvalScaleModeFitCircle,
-			              DEG_TO_TRIGANGLE(83))
-        };
-	GRect date_bg = grect_inset(text_box, GEdgeInsets(font_is_square() ? -1 : -2, 1, 0, 0));
-        graphics_fill_rect(ctx, date_bg, 3, GCornersAll);
-        graphics_draw_text(ctx, s_date, digital_font, text_box, GTextOverflowModeFill,
-                           GTextAlignmentCenter, NULL);
+        graphics_fill_rect(ctx, layout->date_bg, quality == RENDER_QUALITY_FULL ? 3 : 0,
+                           GCornersAll);
+        prv_draw_digits(ctx, s_date, layout->date_box, settings->clock_bg_color);
     }
 }
 
-static void draw_seconds(Layer *layer, GContext *ctx) {
-    GRect layer_bounds = layer_get_unobstructed_bounds(layer);
-    int w = layer_bounds.size.w;
-    int h = layer_bounds.size.h;
-    GPoint center_point = GPoint(w*.5, h*.5);
-    GRect sec_frame = (GRect) { .size = GSize(w*.96, h*.96) };
-    grect_align(&sec_frame, &layer_bounds, GAlignCenter, false);
-    if (enamel_get_display_seconds() && !battery_saver_enabled(clock_state.hour)) {
-        // seconds hand
-	GPoint sec_to = gpoint_from_polar(sec_frame, GOvalScaleModeFitCircle,
-                                          DEG_TO_TRIGANGLE(clock_state.second_angle));
-        // draw seconds hand outline
-	graphics_context_set_stroke_color(ctx, enamel_get_clock_bg_color());
-        graphics_context_set_stroke_width(ctx, 5);
-        graphics_draw_line(ctx, center_point, sec_to);
-	//
-	graphics_context_set_fill_color(ctx, enamel_get_clock_bg_color());
-	graphics_fill_circle(ctx, center_point, 4);
-	// draw seconds hand
-	graphics_context_set_fill_color(ctx, enamel_get_second_hand_color());
-	graphics_fill_circle(ctx, center_point, 3);
-	//
-	graphics_context_set_stroke_color(ctx, enamel_get_second_hand_color());
-        graphics_context_set_stroke_width(ctx, 3);
-        graphics_draw_line(ctx, center_point, sec_to);
-	// draw seconds hand center
-	graphics_context_set_fill_color(ctx, enamel_get_clock_bg_color());
-	graphics_fill_circle(ctx, center_point, 1);
+static void draw_day(GContext *ctx, const DialLayout *layout) {
+  RENDER_STATS_BEGIN(RENDER_PLANE_DAY);
+  draw_day_proc(ctx, layout);
+  RENDER_STATS_END(RENDER_PLANE_DAY);
+}
+
+static void draw_seconds_proc(GContext *ctx, const DialLayout *layout) {
+    const EnamelSettings *settings = enamel_get_settings();
+    if (seconds_visible()) {
+        GPoint center_point = layout->center;
+        GPoint sec_to = second_hand_tip(layout, clock_state.second_angle);
+        if (power_policy_render_quality() != RENDER_QUALITY_FULL) {
+            // single stroke, no outline
+            const HandStroke stroke = HAND_STROKE(center_point, sec_to, 3,
+                                                  settings->second_hand_color);
+            hand_raster_draw(ctx, &stroke, 1, s_damage, prv_antialiased());
+            return;
+        }
+        // outline, hand and center caps, bottom to top
+        const HandStroke strokes[] = {
+            HAND_STROKE(center_point, sec_to, 5, settings->clock_bg_color),
+            HAND_DOT(center_point, 4, settings->clock_bg_color),
+            HAND_DOT(center_point, 3, settings->second_hand_color),
+            HAND_STROKE(center_point, sec_to, 3, settings->second_hand_color),
+            HAND_DOT(center_point, 1, settings->clock_bg_color),
+        };
+        hand_raster_draw(ctx, strokes, ARRAY_LENGTH(strokes), s_damage,
+                         prv_antialiased());
     }
 }
 
-static void draw_marks(Layer *layer, GContext *ctx) {
-    GRect layer_bounds = layer_get_unobstructed_bounds(layer);
+static void draw_seconds(GContext *ctx, const DialLayout *layout) {
+  RENDER_STATS_BEGIN(RENDER_PLANE_SECONDS);
+  draw_seconds_proc(ctx, layout);
+  RENDER_STATS_END(RENDER_PLANE_SECONDS);
+}
+
+static void draw_marks_proc(GContext *ctx, const DialLayout *layout) {
+    const EnamelSettings *settings = enamel_get_settings();
+    // minimal quality only draws the hour marks
+    const bool minimal = power_policy_render_quality() == RENDER_QUALITY_MINIMAL;
+    const bool numerals = prv_numerals_visible();
+#if DIAL_CACHE_STRATEGY == DIAL_CACHE_BITMAP
+    // cached dial, redrawn only after config or bounds changes; while the
+    // unobstructed area moves it is scaled instead
+    if (s_area_changing ? dial_cache_draw_scaled(ctx, layout->bounds)
+                        : dial_cache_draw(ctx, layout->bounds)) {
+        return;
+    }
+#else
+    // recorded dial, replayed until config or bounds changes
+    if (!s_area_changing && dial_list_replay(ctx, layout->bounds)) {
+        return;
+    }
+#endif
+    // neither is the scaled layout of a moving unobstructed area or a dial
+    // without numerals worth recording
+    dial_list_begin(layout->bounds, prv_draw_digits, !s_area_changing && digital_font);
     // screen background
 #if defined(PBL_ROUND)
-    graphics_context_set_fill_color(ctx, GColorBlack);
+    dial_list_fill_rect(ctx, layout->bounds, GColorBlack);
 #else
-    graphics_context_set_fill_color(ctx, enamel_get_screen_color());
+    dial_list_fill_rect(ctx, layout->bounds, settings->screen_color);
 #endif
-    graphics_fill_rect(ctx, layer_bounds, 0, (GCornerMask)NULL);
-    int w = layer_bounds.size.w;
-    int h = layer_bounds.size.h;
-    int angle_from;
+    int32_t angle_from;
     static char s_min_string[5];
     int min;
-    GRect text_frame = (GRect) { .size = GSize(w*.78, h*.78) };
-    grect_align(&text_frame, &layer_bounds, GAlignCenter, false);
-    int text_position = text_frame.origin.y;
-    text_frame.origin.y = text_position - 1;
-    GRect circle_frame = (GRect) { .size = GSize(w, h) };
-    grect_align(&circle_frame, &layer_bounds, GAlignCenter, false);
     // clock background
-    graphics_context_set_fill_color(ctx, enamel_get_clock_bg_color());
-    graphics_fill_radial(ctx, circle_frame, GOvalScaleModeFitCircle, w*.49, 0, TRIG_MAX_ANGLE);
-    GRect outer_frame = (GRect) { .size = GSize(w*.97, h*.97) };
-    grect_align(&outer_frame, &layer_bounds, GAlignCenter, false);
-    GRect inner_frame = (GRect) { .size = GSize(w*.9, h*.9) };
-    grect_align(&inner_frame, &layer_bounds, GAlignCenter, false);
+    dial_list_fill_radial(ctx, layout->dial_frame, layout->dial_inset, settings->clock_bg_color);
     // minute dial markers
-    graphics_context_set_stroke_width(ctx, 1);
-    graphics_context_set_stroke_color(ctx, enamel_get_clock_fg_color());
-    graphics_context_set_text_color(ctx, enamel_get_clock_fg_color());
     for (min = 60; min > 0; min = min - 1) {
-        angle_from = min * 6;
-        if ((min % 5) == 0) {
+        if (minimal && (min % 5) != 0) {
+            continue;
+        }
+        angle_from = clock_angle_minute(min);
+        if ((min % 5) == 0 && numerals) {
 	    // minute text
 	    snprintf(s_min_string, sizeof(s_min_string), "%02d", min);
-            GSize text_size = graphics_text_layout_get_content_size(s_min_string, digital_font,
-                                                                    layer_bounds,
-                                                                    GTextOverflowModeFill,
-                                                                    GTextAlignmentCenter);
-	    GRect text_box = grect_centered_from_polar(text_frame, GOvalScaleModeFitCircle,
-                                                       DEG_TO_TRIGANGLE(angle_from), text_size);
-            graphics_draw_text(ctx, s_min_string, digital_font, text_box,
-                               GTextOverflowModeFill, GTextAlignmentCenter, NULL);
+            dial_list_text(ctx, s_min_string, layout->minute_label_boxes[min / 5 - 1],
+                           settings->clock_fg_color);
 	}
         // minute marks
-	GPoint mark_from = gpoint_from_polar(outer_frame, GOvalScaleModeFitCircle,
-			                     DEG_TO_TRIGANGLE(angle_from));
-	GPoint mark_to = gpoint_from_polar(inner_frame, GOvalScaleModeFitCircle,
-		                          DEG_TO_TRIGANGLE(angle_from));
-	graphics_draw_line(ctx, mark_from, mark_to);
+	GPoint mark_from = dial_layout_point(layout, DIAL_RING_TICK_OUTER, angle_from);
+	GPoint mark_to = dial_layout_point(layout, DIAL_RING_TICK_INNER, angle_from);
+	dial_list_line(ctx, mark_from, mark_to, 1, settings->clock_fg_color);
     }
     // hour dial center
-    GRect hour_frame = (GRect) { .size = GSize(w*.46, h*.46) };
-    grect_align(&hour_frame, &layer_bounds, GAlignCenter, false);
-    hour_frame.origin.x = hour_frame.origin.x + 1;
-    hour_frame.origin.y = hour_frame.origin.y - (font_is_square() ? 1 : 0);
     int hour;
     char s_hour_string[5];
-    graphics_context_set_text_color(ctx, enamel_get_clock_fg_color());
-    for (hour = 12; hour > 0; hour = hour-1) {
-        int hour_angle = hour * 30;
+    for (hour = 12; hour > 0 && numerals; hour = hour-1) {
         snprintf(s_hour_string, sizeof(s_hour_string), "%d", hour);
-        GSize hour_size = graphics_text_layout_get_content_size(s_hour_string, digital_font,
-                                                                layer_bounds,
-                                                                GTextOverflowModeFill,
-                                                                GTextAlignmentCenter);
-        GRect hour_box = grect_centered_from_polar(hour_frame, GOvalScaleModeFitCircle,
-                                                   DEG_TO_TRIGANGLE(hour_angle), hour_size);
-        graphics_draw_text(ctx, s_hour_string, digital_font, hour_box,
-                           GTextOverflowModeFill, GTextAlignmentCenter, NULL);
+        dial_list_text(ctx, s_hour_string, layout->hour_label_boxes[hour - 1],
+                       settings->clock_fg_color);
     }
     // outline around hour dial
-    if (enamel_get_draw_hour_circle()) {
-	int radius = h*.25;
-        GPoint center_point = GPoint(w*.5, h*.5);
-        graphics_context_set_stroke_width(ctx, 1);
-        graphics_context_set_stroke_color(ctx, enamel_get_clock_fg_color());
-        graphics_draw_circle(ctx, center_point, radius < 35 ? 35 : radius);
+    if (settings->draw_hour_circle) {
+        dial_list_circle(ctx, layout->center, layout->hour_circle_radius, 1,
+                         settings->clock_fg_color);
+    }
+    dial_list_end();
+#if DIAL_CACHE_STRATEGY == DIAL_CACHE_BITMAP
+    // a clipped frame only repainted part of the dial
+    if (s_damage_is_full && !s_area_changing && digital_font) {
+        dial_cache_store(ctx, layout->bounds);
     }
+#endif
+}
+
+static void draw_marks(GContext *ctx, const DialLayout *layout) {
+  RENDER_STATS_BEGIN(RENDER_PLANE_MARKS);
+  draw_marks_proc(ctx, layout);
+  RENDER_STATS_END(RENDER_PLANE_MARKS);
 }
 
-static void draw_clock(Layer *layer, GContext *ctx) {
-    GRect layer_bounds = layer_get_unobstructed_bounds(layer);
-    int w = layer_bounds.size.w;
-    int h = layer_bounds.size.h;
-    GPoint center_point = GPoint(w*.5, h*.5);
+// A hand is a thin stroke from the center to the tip, widened from the
+// base on, each with an outline in the dial color. Below full quality it
+// is a single stroke.
+static int prv_hand_strokes(HandStroke *strokes, GPoint center, GPoint base, GPoint tip,
+                            GColor color, GColor outline) {
+    if (power_policy_render_quality() != RENDER_QUALITY_FULL) {
+        strokes[0] = HAND_STROKE(center, tip, 5, color);
+        return 1;
+    }
+    strokes[0] = HAND_STROKE(center, tip, 5, outline);
+    strokes[1] = HAND_STROKE(base, tip, 9, outline);
+    strokes[2] = HAND_STROKE(center, tip, 3, color);
+    strokes[3] = HAND_STROKE(base, tip, 7, color);
+    return 4;
+}
+
+static void draw_clock_proc(GContext *ctx, const DialLayout *layout) {
+    const EnamelSettings *settings = enamel_get_settings();
+    GPoint center_point = layout->center;
+    HandStroke strokes[HAND_RASTER_MAX_STROKES];
+    int count = 0;
     // minute hand
-    GRect slim_min_frame = (GRect) { .size = GSize(w*.19, h*.19) };
-    grect_align(&slim_min_frame, &layer_bounds, GAlignCenter, false);
-    GRect min_frame = (GRect) { .size = GSize(w*.92, h*.92) };
-    grect_align(&min_frame, &layer_bounds, GAlignCenter, false);
-    GPoint slim_min_to = gpoint_from_polar(slim_min_frame, GOvalScaleModeFitCircle,
-		                           DEG_TO_TRIGANGLE(clock_state.minute_angle));
-    GPoint min_from = slim_min_to;
-    GPoint min_to = gpoint_from_polar(min_frame, GOvalScaleModeFitCircle,
-                                      DEG_TO_TRIGANGLE(clock_state.minute_angle));
-    // draw minute hand outline
-    graphics_context_set_stroke_color(ctx, enamel_get_clock_bg_color());
-    graphics_context_set_stroke_width(ctx, 5);
-    //graphics_draw_line(ctx, center_point, slim_min_to);
-    graphics_draw_line(ctx, center_point, min_to);
-    graphics_context_set_stroke_width(ctx, 9);
-    graphics_draw_line(ctx, min_from, min_to);
-    // draw minute hand
-    graphics_context_set_stroke_color(ctx, enamel_get_minute_hand_color());
-    graphics_context_set_stroke_width(ctx, 3);
-    //graphics_draw_line(ctx, center_point, slim_min_to);
-    graphics_draw_line(ctx, center_point, min_to);
-    graphics_context_set_stroke_width(ctx, 7);
-    graphics_draw_line(ctx, min_from, min_to);
-    // hour hand
-    GRect hour_frame = (GRect) { .size = GSize(w*.5, h*.5) };
-    grect_align(&hour_frame, &layer_bounds, GAlignCenter, false);
-    GPoint slim_hour_to = gpoint_from_polar(slim_min_frame, GOvalScaleModeFitCircle,
-                                            DEG_TO_TRIGANGLE(clock_state.hour_angle));
-    GPoint hour_from = slim_hour_to;
-    GPoint hour_to = gpoint_from_polar(hour_frame, GOvalScaleModeFitCircle,
-                                       DEG_TO_TRIGANGLE(clock_state.hour_angle));
-    // draw hour hand outline
-    graphics_context_set_stroke_color(ctx, enamel_get_clock_bg_color());
-    graphics_context_set_stroke_width(ctx, 5);
-    if (!enamel_get_display_seconds() || battery_saver_enabled(clock_state.hour)) {
-        graphics_context_set_fill_color(ctx, enamel_get_clock_bg_color());
-        graphics_fill_circle(ctx, center_point, 4);
+    GPoint min_from = dial_layout_point(layout, DIAL_RING_HAND_BASE, clock_state.minute_angle);
+    GPoint min_to = dial_layout_point(layout, DIAL_RING_MINUTE_HAND, clock_state.minute_angle);
+    count += prv_hand_strokes(&strokes[count], center_point, min_from, min_to,
+                              settings->minute_hand_color, settings->clock_bg_color);
+    hand_raster_draw(ctx, strokes, count, s_damage, prv_antialiased());
+    // hour hand, with the center caps when the seconds hand does not cover it
+    count = 0;
+    GPoint hour_from = dial_layout_point(layout, DIAL_RING_HAND_BASE, clock_state.hour_angle);
+    GPoint hour_to = dial_layout_point(layout, DIAL_RING_HOUR_HAND, clock_state.hour_angle);
+    if (!seconds_visible()) {
+        strokes[count++] = HAND_DOT(center_point, 4, settings->clock_bg_color);
     }
-    //graphics_draw_line(ctx, center_point, slim_hour_to);
-    graphics_draw_line(ctx, center_point, hour_to);
-    graphics_context_set_stroke_width(ctx, 9);
-    graphics_draw_line(ctx, hour_from, hour_to);
-    // draw hour hand
-    graphics_context_set_stroke_color(ctx, enamel_get_hour_hand_color());
-    graphics_context_set_stroke_width(ctx, 3);
-    //graphics_draw_line(ctx, center_point, slim_hour_to);
-    graphics_draw_line(ctx, center_point, hour_to);
-    graphics_context_set_stroke_width(ctx, 7);
-    graphics_draw_line(ctx, hour_from, hour_to);
-    if (!enamel_get_display_seconds() || battery_saver_enabled(clock_state.hour)) {
-        graphics_context_set_fill_color(ctx, enamel_get_hour_hand_color());
-        graphics_fill_circle(ctx, center_point, 3);
-        graphics_context_set_fill_color(ctx, enamel_get_clock_bg_color());
-        graphics_fill_circle(ctx, center_point, 1);
+    count += prv_hand_strokes(&strokes[count], center_point, hour_from, hour_to,
+                              settings->hour_hand_color, settings->clock_bg_color);
+    if (!seconds_visible()) {
+        strokes[count++] = HAND_DOT(center_point, 3, settings->hour_hand_color);
+        strokes[count++] = HAND_DOT(center_point, 1, settings->clock_bg_color);
     }
+    hand_raster_draw(ctx, strokes, count, s_damage, prv_antialiased());
 }
 
-static void prv_app_did_focus(bool did_focus) {
-  if (!did_focus) {
+static void draw_clock(GContext *ctx, const DialLayout *layout) {
+  RENDER_STATS_BEGIN(RENDER_PLANE_CLOCK);
+  draw_clock_proc(ctx, layout);
+  RENDER_STATS_END(RENDER_PLANE_CLOCK);
+}
+
+typedef void (*DrawPlane)(GContext *ctx, const DialLayout *layout);
+
+static const DrawPlane s_plane_procs[DIAL_PLANE_COUNT] = {
+  [DIAL_PLANE_MARKS] = draw_marks,
+  [DIAL_PLANE_DAY] = draw_day,
+  [DIAL_PLANE_CLOCK] = draw_clock,
+  [DIAL_PLANE_SECONDS] = draw_seconds,
+};
+
+static bool prv_rects_overlap(GRect a, GRect b) {
+  return a.origin.x < b.origin.x + b.size.w && b.origin.x < a.origin.x + a.size.w &&
+         a.origin.y < b.origin.y + b.size.h && b.origin.y < a.origin.y + a.size.h;
+}
+
+// Area a plane can paint on. The date box is the only plane smaller than
+// the dial, so it is left alone by the seconds hand unless they meet.
+static GRect prv_plane_extent(DialPlane plane) {
+  return plane == DIAL_PLANE_DAY ? s_layout.date_bg : s_layout.bounds;
+}
+
+// Draws the planes bottom to top: the ones that changed, plus the ones
+// under or over the damaged area since it is painted from scratch.
+static void draw_compositor(Layer *layer, GContext *ctx) {
+  graphics_context_set_antialiased(ctx, prv_antialiased());
+  // the atlas scribbles on screen, only build it when all is repainted
+  if (!digit_atlas_ready() && s_damage_is_full && digital_font) {
+    digit_atlas_build(ctx, digital_font, s_layout.bounds);
+  }
+  for (int plane = 0; plane < DIAL_PLANE_COUNT; plane++) {
+    if ((s_dirty_planes & DIAL_PLANE_BIT(plane)) ||
+        prv_rects_overlap(prv_plane_extent(plane), s_damage)) {
+      s_plane_procs[plane](ctx, &s_layout);
+    }
+  }
+  // the damaged area has been repainted
+  s_dirty_planes = 0;
+  s_damage_pending = false;
+  if (s_startup_stage != STARTUP_DONE) {
+    prv_startup_frame_drawn();
+  }
+}
+
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+// While a Timeline Quick View slides in or out, the layout and the cached
+// dial are scaled from the ones before the transition; the exact geometry
+// is computed once it is over.
+static EventHandle s_unobstructed_area_handle;
+static DialLayout s_area_from_layout;
+
+static void prv_unobstructed_will_change(GRect final_unobstructed_screen_area, void *context) {
+  // a transition reversed midway keeps scaling from the exact layout
+  if (!s_area_changing) {
+    s_area_from_layout = s_layout;
+  }
+  s_area_changing = true;
+}
+
+static void prv_unobstructed_change(AnimationProgress progress, void *context) {
+  GRect bounds = layer_get_unobstructed_bounds(window_get_root_layer(window));
+  if (!s_area_changing || grect_equal(&bounds, &s_layout.bounds)) {
     return;
   }
-  app_focus_service_unsubscribe();
-  watch_model_init();
-  watch_model_start_intro(clock_state);
+  dial_layout_scale(&s_layout, &s_area_from_layout, bounds);
+  prv_invalidate_all(DIAL_PLANES_ALL);
 }
 
-int start_angle(int hour) {
-  if (enamel_get_intro_enabled() && !battery_saver_enabled(hour)) {
+static void prv_unobstructed_did_change(void *context) {
+  s_area_changing = false;
+  prv_update_layout();
+  prv_invalidate_all(DIAL_PLANES_ALL);
+}
+#endif
+
+int32_t start_angle(void) {
+  if (enamel_get_intro_enabled() && power_policy_features_enabled()) {
     //int angles[] = { 45, 90, 135, 180, 225, 270, 315, 360 };
     int angles[] = { 180, 225, 270, 315, 360 };
     int direction = rand()%2 ? 1 : -1;
     //int angle = angles[rand()%8];
     int angle = angles[rand()%5];
-    return angle * direction;
+    return CLOCK_ANGLE_DEGREES(angle) * direction;
   }
   else
     return 0;
 }
 
+// The watch model and the intro wait for both the complete dial and the
+// window transition to be over.
+static void prv_start_model(void) {
+  if (!s_focused || s_startup_stage != STARTUP_START_MODEL) {
+    return;
+  }
+  s_startup_stage = STARTUP_DONE;
+  watch_model_init();
+  watch_model_start_intro(clock_state);
+  RENDER_STATS_STARTUP("interactive");
+}
+
+static void prv_startup_step(void *context) {
+  s_startup_timer = NULL;
+  if (s_startup_stage == STARTUP_LOAD_DIAL) {
+    digital_font = fonts_load_custom_font(get_font_handle());
+    digit_atlas_destroy();
+    prv_update_layout();
+    dial_cache_invalidate();
+    dial_list_invalidate();
+    prv_invalidate_all(DIAL_PLANES_ALL);
+    s_startup_stage = STARTUP_DIAL;
+    MEMORY_STATS_SAMPLE("font load");
+  }
+  else {
+    prv_start_model();
+  }
+}
+
+static void prv_startup_frame_drawn(void) {
+  if (s_startup_stage == STARTUP_FIRST_FRAME) {
+    RENDER_STATS_STARTUP("first frame");
+    s_startup_stage = STARTUP_LOAD_DIAL;
+  }
+  else if (s_startup_stage == STARTUP_DIAL) {
+    RENDER_STATS_STARTUP("dial");
+    s_startup_stage = STARTUP_START_MODEL;
+  }
+  else {
+    return;
+  }
+  s_startup_timer = app_timer_register(0, prv_startup_step, NULL);
+}
+
+// Partial repaints rely on the frame buffer surviving between frames. A
+// modal window or a notification drawn over the face does not always make
+// it appear again, so every focus repaints it all.
+static void prv_app_did_focus(bool did_focus) {
+  if (!did_focus) {
+    return;
+  }
+  prv_invalidate_all(DIAL_PLANES_ALL);
+  s_focused = true;
+  prv_start_model();
+}
+
 static void window_load(Window *window) {
   time_t tm = time(NULL);
   struct tm *tick_time = localtime(&tm);
   clock_state = (ClockState) {
-    .minute_angle = tick_time->tm_min * 6 + start_angle(tick_time->tm_hour),
-    .hour_angle = tick_time->tm_hour%12 * 30 + (tick_time->tm_min*6)*.08 + start_angle(tick_time->tm_hour),
-    .second_angle = tick_time->tm_sec * 6 + start_angle(tick_time->tm_hour),
-    .date = (enamel_get_intro_enabled() && !battery_saver_enabled(tick_time->tm_hour)) ? 0 : tick_time->tm_mday,
+    .minute_angle = clock_angle_minute(tick_time->tm_min) + start_angle(),
+    .hour_angle = clock_angle_hour(tick_time->tm_hour, tick_time->tm_min) + start_angle(),
+    .second_angle = clock_angle_second(tick_time->tm_sec, 0) + start_angle(),
+    .date = (enamel_get_intro_enabled() && power_policy_features_enabled()) ? 0 : tick_time->tm_mday,
     .hour = tick_time->tm_hour
   };
   Layer *const window_layer = window_get_root_layer(window);
   const GRect bounds = layer_get_bounds(window_layer);
-  // minutes and hours marks layer
-  marks_layer = layer_create(bounds);
-  layer_set_update_proc(marks_layer, draw_marks);
-  layer_add_child(window_layer, marks_layer);
-  // day layer
-  day_layer = layer_create(bounds);
-  layer_set_update_proc(day_layer, draw_day);
-  layer_add_child(window_layer, day_layer);
-  // clock layer (hour an minute hands)
-  clock_layer = layer_create(bounds);
-  layer_set_update_proc(clock_layer, draw_clock);
-  layer_add_child(window_layer, clock_layer);
-  // seconds layer
-  seconds_layer = layer_create(bounds);
-  layer_set_update_proc(seconds_layer, draw_seconds);
-  layer_add_child(window_layer, seconds_layer);
-  // load font
-  digital_font = fonts_load_custom_font(get_font_handle());
+  // keep the last frame around so partial redraws can be composited on it
+  window_set_background_color(window, GColorClear);
+  // compositor layer, draws every plane clipped to the damaged area
+  compositor_layer = layer_create(bounds);
+  layer_set_update_proc(compositor_layer, draw_compositor);
+  layer_add_child(window_layer, compositor_layer);
+  s_canvas_bounds = bounds;
+  // the font waits for the first frame, so does anything that needs it
+  prv_update_layout();
+  dial_cache_invalidate();
+  dial_list_invalidate();
+  prv_invalidate_all(DIAL_PLANES_ALL);
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+  s_unobstructed_area_handle = events_unobstructed_area_service_subscribe(
+      (UnobstructedAreaHandlers) {
+        .will_change = prv_unobstructed_will_change,
+        .change = prv_unobstructed_change,
+        .did_change = prv_unobstructed_did_change,
+      }, NULL);
+#endif
+  MEMORY_STATS_SAMPLE("window_load");
+}
+
+static void window_appear(Window *window) {
+  prv_invalidate_all(DIAL_PLANES_ALL);
 }
 
 static void window_unload(Window *window) {
-  fonts_unload_custom_font(digital_font);
-  layer_destroy(clock_layer);
-  layer_destroy(seconds_layer);
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+  events_unobstructed_area_service_unsubscribe(s_unobstructed_area_handle);
+#endif
+  if (s_startup_timer) {
+    app_timer_cancel(s_startup_timer);
+    s_startup_timer = NULL;
+  }
+  if (digital_font) {
+    fonts_unload_custom_font(digital_font);
+    digital_font = NULL;
+  }
+  digit_atlas_destroy();
+  dial_cache_destroy();
+  layer_destroy(compositor_layer);
 }
 
+// Taps are subscribed for the tap animation, the seconds burst or both
 void accel_tap_handler(AccelAxisType axis, int32_t direction) {
-    schedule_tap_animation(clock_state);
+    watch_model_start_seconds_burst();
+    if (enamel_get_tap_to_animate() && power_policy_features_enabled()) {
+        schedule_tap_animation(clock_state);
+    }
 }
 
 static void init(void) {
+  RENDER_STATS_LAUNCH();
+  memory_stats_init();
   enamel_init(0, 0);
+  render_stats_init();
+  power_policy_init(watch_model_handle_power_change);
   window = window_create();
   window_set_window_handlers(window, (WindowHandlers) {
     .load = window_load,
+    .appear = window_appear,
     .unload = window_unload,
   });
   window_stack_push(window, true /* animated */);
@@ -375,9 +640,13 @@ static void init(void) {
 }
 
 static void deinit(void) {
+  app_focus_service_unsubscribe();
   enamel_deinit();
+  render_stats_deinit();
+  power_policy_deinit();
   watch_model_deinit();
   window_destroy(window);
+  memory_stats_deinit();
 }
 
 int main(void) {
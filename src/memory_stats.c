@@ -0,0 +1,189 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "memory_stats.h"
+
+#if defined(MEMORY_STATS)
+
+#include <string.h>
+
+#define MEMORY_SITE_COUNT 16
+#define MEMORY_BLOCK_COUNT 32
+
+typedef struct {
+  const char *file;
+  uint16_t line;
+  uint16_t blocks;
+  uint32_t bytes;
+  uint32_t peak_bytes;
+} MemorySite;
+
+typedef struct {
+  const void *ptr;
+  uint16_t bytes;
+  uint8_t site;
+} MemoryBlock;
+
+typedef struct {
+  MemorySite sites[MEMORY_SITE_COUNT];
+  MemoryBlock blocks[MEMORY_BLOCK_COUNT];
+  uint8_t site_count;
+  uint32_t heap_size;
+  uint32_t used;
+  uint32_t peak;
+  const char *peak_point;
+  uint32_t untracked;
+} MemoryStats;
+
+static MemoryStats s_stats;
+static size_t s_mark;
+
+static const char *prv_basename(const char *file) {
+  const char *slash = strrchr(file, '/');
+  return slash ? slash + 1 : file;
+}
+
+static int prv_site(const char *file, int line) {
+  for (int i = 0; i < s_stats.site_count; i++) {
+    if (s_stats.sites[i].line == line && strcmp(s_stats.sites[i].file, file) == 0) {
+      return i;
+    }
+  }
+  if (s_stats.site_count == MEMORY_SITE_COUNT) {
+    return -1;
+  }
+  s_stats.sites[s_stats.site_count] = (MemorySite) { .file = file, .line = line };
+  return s_stats.site_count++;
+}
+
+static void prv_track(const void *ptr, size_t bytes, const char *file, int line) {
+  int site = prv_site(file, line);
+  MemoryBlock *block = NULL;
+  for (int i = 0; i < MEMORY_BLOCK_COUNT && !block; i++) {
+    if (!s_stats.blocks[i].ptr) {
+      block = &s_stats.blocks[i];
+    }
+  }
+  if (site < 0 || !block) {
+    s_stats.untracked++;
+    return;
+  }
+  *block = (MemoryBlock) { .ptr = ptr, .bytes = bytes, .site = site };
+  MemorySite *stats = &s_stats.sites[site];
+  stats->blocks++;
+  stats->bytes += bytes;
+  if (stats->bytes > stats->peak_bytes) {
+    stats->peak_bytes = stats->bytes;
+  }
+}
+
+void *memory_stats_alloc(void *ptr, size_t size, const char *file, int line) {
+  if (ptr) {
+    prv_track(ptr, size, file, line);
+  }
+  memory_stats_sample(NULL);
+  return ptr;
+}
+
+void memory_stats_mark(void) {
+  s_mark = heap_bytes_used();
+}
+
+void *memory_stats_created(void *ptr, const char *file, int line) {
+  if (ptr) {
+    size_t used = heap_bytes_used();
+    prv_track(ptr, used > s_mark ? used - s_mark : 0, file, line);
+  }
+  memory_stats_sample(NULL);
+  return ptr;
+}
+
+void memory_stats_release(const void *ptr) {
+  if (!ptr) {
+    return;
+  }
+  for (int i = 0; i < MEMORY_BLOCK_COUNT; i++) {
+    MemoryBlock *block = &s_stats.blocks[i];
+    if (block->ptr == ptr) {
+      MemorySite *site = &s_stats.sites[block->site];
+      site->blocks--;
+      site->bytes -= block->bytes;
+      block->ptr = NULL;
+      return;
+    }
+  }
+}
+
+// Allocations sample without a point so the peak is caught where it
+// happens; named points are logged as well.
+void memory_stats_sample(const char *point) {
+  s_stats.used = heap_bytes_used();
+  if (s_stats.used > s_stats.peak) {
+    s_stats.peak = s_stats.used;
+    s_stats.peak_point = point;
+  }
+  if (point) {
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "heap at %s: %lu used, %lu free, %lu peak", point,
+            (unsigned long)s_stats.used, (unsigned long)heap_bytes_free(),
+            (unsigned long)s_stats.peak);
+  }
+}
+
+void memory_stats_tick(TimeUnits units_changed) {
+  if (units_changed & HOUR_UNIT) {
+    memory_stats_dump();
+  }
+}
+
+void memory_stats_dump(void) {
+  memory_stats_sample(NULL);
+  uint32_t peak_free = s_stats.heap_size > s_stats.peak ? s_stats.heap_size - s_stats.peak : 0;
+  APP_LOG(peak_free < MEMORY_STATS_HEADROOM ? APP_LOG_LEVEL_WARNING : APP_LOG_LEVEL_INFO,
+          "heap: %lu/%lu used, %lu peak (at %s), %lu free at peak, %lu untracked blocks",
+          (unsigned long)s_stats.used, (unsigned long)s_stats.heap_size,
+          (unsigned long)s_stats.peak, s_stats.peak_point ? s_stats.peak_point : "an allocation",
+          (unsigned long)peak_free, (unsigned long)s_stats.untracked);
+  for (int i = 0; i < s_stats.site_count; i++) {
+    const MemorySite *site = &s_stats.sites[i];
+    APP_LOG(APP_LOG_LEVEL_INFO, "%s:%u: %u blocks, %lu bytes, %lu peak", prv_basename(site->file),
+            site->line, site->blocks, (unsigned long)site->bytes,
+            (unsigned long)site->peak_bytes);
+  }
+}
+
+void memory_stats_init(void) {
+  s_stats.heap_size = heap_bytes_used() + heap_bytes_free();
+  memory_stats_sample("init");
+}
+
+// Everything the instrumented files allocate is released by now, what is
+// left is a leak.
+void memory_stats_deinit(void) {
+  memory_stats_dump();
+  for (int i = 0; i < s_stats.site_count; i++) {
+    const MemorySite *site = &s_stats.sites[i];
+    if (site->blocks) {
+      APP_LOG(APP_LOG_LEVEL_WARNING, "leak: %s:%u holds %u blocks, %lu bytes",
+              prv_basename(site->file), site->line, site->blocks, (unsigned long)site->bytes);
+    }
+  }
+}
+
+#endif
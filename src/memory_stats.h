@@ -0,0 +1,77 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <pebble.h>
+#include <stdlib.h>
+
+// Optional heap instrumentation, built when MEMORY_STATS is defined (set
+// VUELA_MEMORY_STATS=1 when building, which also writes a static memory
+// budget per platform next to each app binary). Samples the current and
+// peak heap at the points passed to MEMORY_STATS_SAMPLE and tallies the
+// outstanding allocations per call site of the files including this
+// header. The report is logged every hour and when the app exits, with a
+// warning for sites still holding memory at exit and for peaks leaving
+// less than MEMORY_STATS_HEADROOM bytes free.
+//
+// Include it after the system headers: it wraps malloc and free.
+
+#define MEMORY_STATS_HEADROOM 1024
+
+#if defined(MEMORY_STATS)
+
+void memory_stats_init(void);
+void memory_stats_deinit(void);
+void memory_stats_sample(const char *point);
+void memory_stats_tick(TimeUnits units_changed);
+void memory_stats_dump(void);
+void *memory_stats_alloc(void *ptr, size_t size, const char *file, int line);
+void memory_stats_mark(void);
+void *memory_stats_created(void *ptr, const char *file, int line);
+void memory_stats_release(const void *ptr);
+
+#define MEMORY_STATS_SAMPLE(point) memory_stats_sample(point)
+#define MEMORY_STATS_TICK(units_changed) memory_stats_tick(units_changed)
+
+// track the heap blocks taken by the files including this header; the
+// size of the ones the system allocates is the change in heap usage
+#define MEMORY_STATS_CREATED(create) \
+  (memory_stats_mark(), memory_stats_created(create, __FILE__, __LINE__))
+#define MEMORY_STATS_DESTROYED(destroy, ptr) (memory_stats_release(ptr), destroy(ptr))
+
+#define malloc(size) memory_stats_alloc(malloc(size), (size), __FILE__, __LINE__)
+#define free(ptr) MEMORY_STATS_DESTROYED(free, ptr)
+#define window_create() MEMORY_STATS_CREATED(window_create())
+#define window_destroy(window) MEMORY_STATS_DESTROYED(window_destroy, window)
+#define layer_create(frame) MEMORY_STATS_CREATED(layer_create(frame))
+#define layer_destroy(layer) MEMORY_STATS_DESTROYED(layer_destroy, layer)
+#define gbitmap_create_blank(size, format) MEMORY_STATS_CREATED(gbitmap_create_blank(size, format))
+#define gbitmap_destroy(bitmap) MEMORY_STATS_DESTROYED(gbitmap_destroy, bitmap)
+#define fonts_load_custom_font(handle) MEMORY_STATS_CREATED(fonts_load_custom_font(handle))
+#define fonts_unload_custom_font(font) MEMORY_STATS_DESTROYED(fonts_unload_custom_font, font)
+#define linked_list_create_root() MEMORY_STATS_CREATED(linked_list_create_root())
+
+#else
+
+#define memory_stats_init()
+#define memory_stats_deinit()
+#define MEMORY_STATS_SAMPLE(point)
+#define MEMORY_STATS_TICK(units_changed)
+
+#endif
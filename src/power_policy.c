@@ -0,0 +1,132 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "power_policy.h"
+#include "enamel.h"
+#include <pebble-events/pebble-events.h>
+
+#define REDUCED_BATTERY_PERCENT 20
+#define MINIMAL_BATTERY_PERCENT 10
+
+static PowerState s_state;
+static PowerStateHandler *s_handler;
+static EventHandle s_battery_handle;
+static BatteryChargeState s_battery;
+static int s_hour;
+
+static bool prv_battery_saver_enabled(int hour) {
+    const EnamelSettings *settings = enamel_get_settings();
+    if (settings->battery_saver_enabled) {
+        int hours[] = { 19, 20, 21, 22, 23, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+        int from = settings->battery_saver_start;
+        int to = settings->battery_saver_stop;
+        int hour_index  = -1;
+        int i;
+        for (i = from; i <= to; i++) {
+            if (hours[i] == hour) {
+                hour_index = i;
+        	break;
+            }
+        }
+        return (hour_index >= from) && (hour_index < to);
+    }
+    return false;
+}
+
+static PowerState prv_evaluate(void) {
+  PowerState state = POWER_STATE_FULL;
+  if (!s_battery.is_charging && !s_battery.is_plugged) {
+    if (s_battery.charge_percent <= MINIMAL_BATTERY_PERCENT) {
+      return POWER_STATE_MINIMAL;
+    }
+    if (s_battery.charge_percent <= REDUCED_BATTERY_PERCENT) {
+      state = POWER_STATE_REDUCED;
+    }
+  }
+  if (prv_battery_saver_enabled(s_hour)) {
+    state = POWER_STATE_REDUCED;
+  }
+  return state;
+}
+
+static void prv_apply(void) {
+  PowerState state = prv_evaluate();
+  if (state != s_state) {
+    const PowerState previous = s_state;
+    s_state = state;
+    if (s_handler) {
+      s_handler(state, previous);
+    }
+  }
+}
+
+static void prv_battery_state_handler(BatteryChargeState charge) {
+  s_battery = charge;
+  prv_apply();
+}
+
+void power_policy_init(PowerStateHandler *handler) {
+  time_t t = time(NULL);
+  s_hour = localtime(&t)->tm_hour;
+  s_battery = battery_state_service_peek();
+  s_state = prv_evaluate();
+  s_handler = handler;
+  s_battery_handle = events_battery_state_service_subscribe(prv_battery_state_handler);
+}
+
+void power_policy_deinit(void) {
+  events_battery_state_service_unsubscribe(s_battery_handle);
+  s_handler = NULL;
+}
+
+// Called on hour boundaries and when the settings change.
+void power_policy_update(int hour) {
+  s_hour = hour;
+  prv_apply();
+}
+
+PowerState power_policy_get_state(void) {
+  return s_state;
+}
+
+// Seconds hand, intro and tap animations are only enabled in the full state.
+bool power_policy_features_enabled(void) {
+  return power_policy_state_features_enabled(s_state);
+}
+
+RenderQuality power_policy_render_quality(void) {
+  return power_policy_state_render_quality(s_state);
+}
+
+bool power_policy_state_features_enabled(PowerState state) {
+  return state == POWER_STATE_FULL;
+}
+
+RenderQuality power_policy_state_render_quality(PowerState state) {
+  const EnamelSettings *settings = enamel_get_settings();
+  switch (state) {
+    case POWER_STATE_REDUCED:
+      return (RenderQuality)settings->saver_quality;
+    case POWER_STATE_MINIMAL:
+      return (RenderQuality)settings->low_battery_quality;
+    default:
+      return RENDER_QUALITY_FULL;
+  }
+}
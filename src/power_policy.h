@@ -0,0 +1,55 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <pebble.h>
+
+// Power states, from everything enabled to the cheapest setup. The state
+// follows the battery saver schedule and the battery level, and handlers
+// are only called when it actually changes.
+typedef enum {
+  POWER_STATE_FULL,
+  POWER_STATE_REDUCED,
+  POWER_STATE_MINIMAL
+} PowerState;
+
+// How much detail is drawn, picked for the reduced and minimal power
+// states in the settings; the full state always draws everything.
+typedef enum {
+  // antialiased dial and hands on color displays, outlined hands
+  RENDER_QUALITY_FULL,
+  // no antialiasing, single stroke hands written straight into the frame
+  // buffer, square date box
+  RENDER_QUALITY_REDUCED,
+  // also only the hour marks, no numerals and no date
+  RENDER_QUALITY_MINIMAL
+} RenderQuality;
+
+// Gets the new state and the one it replaces
+typedef void (PowerStateHandler)(PowerState state, PowerState previous);
+
+void power_policy_init(PowerStateHandler *handler);
+void power_policy_deinit(void);
+void power_policy_update(int hour);
+PowerState power_policy_get_state(void);
+bool power_policy_features_enabled(void);
+RenderQuality power_policy_render_quality(void);
+// same as the above, in the given state
+bool power_policy_state_features_enabled(PowerState state);
+RenderQuality power_policy_state_render_quality(PowerState state);
@@ -0,0 +1,152 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "render_stats.h"
+
+#if defined(RENDER_STATS)
+
+#include <pebble-events/pebble-events.h>
+
+#define FRAME_RING_SIZE 8
+
+typedef struct {
+  uint32_t redraws;
+  uint32_t draw_calls;
+  uint32_t ms;
+} PlaneStats;
+
+typedef struct {
+  uint16_t ms;
+  uint16_t draw_calls;
+} PlaneFrame;
+
+typedef struct {
+  PlaneStats planes[RENDER_PLANE_COUNT];
+  uint32_t ticks;
+  uint32_t animation_frames;
+  uint32_t dirty_marks;
+  uint32_t redundant_dirty_marks;
+  uint32_t frames;
+  PlaneFrame ring[FRAME_RING_SIZE][RENDER_PLANE_COUNT];
+} RenderStats;
+
+static RenderStats s_stats;
+static RenderPlane s_plane;
+static uint32_t s_plane_start;
+static uint32_t s_plane_draw_calls;
+static EventHandle s_inbox_handle;
+static uint32_t s_launch_ms;
+
+static uint32_t prv_now_ms(void) {
+  time_t seconds;
+  uint16_t ms;
+  time_ms(&seconds, &ms);
+  return (uint32_t)seconds * 1000 + ms;
+}
+
+void render_stats_begin(RenderPlane plane) {
+  // marks is the bottom plane, a new frame starts with it
+  if (plane == RENDER_PLANE_MARKS) {
+    s_stats.frames++;
+    memset(s_stats.ring[s_stats.frames % FRAME_RING_SIZE], 0, sizeof(s_stats.ring[0]));
+  }
+  s_plane = plane;
+  s_plane_draw_calls = 0;
+  s_plane_start = prv_now_ms();
+}
+
+void render_stats_end(RenderPlane plane) {
+  uint32_t elapsed = prv_now_ms() - s_plane_start;
+  PlaneStats *stats = &s_stats.planes[plane];
+  stats->redraws++;
+  stats->draw_calls += s_plane_draw_calls;
+  stats->ms += elapsed;
+  PlaneFrame *frame = &s_stats.ring[s_stats.frames % FRAME_RING_SIZE][plane];
+  frame->ms = elapsed;
+  frame->draw_calls = s_plane_draw_calls;
+}
+
+void render_stats_draw_call(void) {
+  s_plane_draw_calls++;
+}
+
+void render_stats_tick(TimeUnits units_changed) {
+  s_stats.ticks++;
+  if (units_changed & HOUR_UNIT) {
+    render_stats_dump();
+  }
+}
+
+void render_stats_animation_frame(void) {
+  s_stats.animation_frames++;
+}
+
+void render_stats_dirty(bool changed) {
+  s_stats.dirty_marks++;
+  if (!changed) {
+    s_stats.redundant_dirty_marks++;
+  }
+}
+
+void render_stats_dump(void) {
+  static const char *const names[RENDER_PLANE_COUNT] = { "marks", "day", "clock", "seconds" };
+  for (int i = 0; i < RENDER_PLANE_COUNT; i++) {
+    const PlaneStats *stats = &s_stats.planes[i];
+    APP_LOG(APP_LOG_LEVEL_INFO, "%s: %lu redraws, %lu draw calls, %lu ms", names[i],
+            (unsigned long)stats->redraws, (unsigned long)stats->draw_calls,
+            (unsigned long)stats->ms);
+  }
+  APP_LOG(APP_LOG_LEVEL_INFO, "%lu frames, %lu ticks, %lu animation frames, %lu/%lu redundant dirty marks",
+          (unsigned long)s_stats.frames, (unsigned long)s_stats.ticks,
+          (unsigned long)s_stats.animation_frames, (unsigned long)s_stats.redundant_dirty_marks,
+          (unsigned long)s_stats.dirty_marks);
+  DictionaryIterator *iter;
+  if (app_message_outbox_begin(&iter) == APP_MSG_OK) {
+    dict_write_data(iter, MESSAGE_KEY_render_stats, (const uint8_t *)&s_stats, sizeof(s_stats));
+    app_message_outbox_send();
+  }
+}
+
+static void prv_inbox_received_handler(DictionaryIterator *iter, void *context) {
+  if (dict_find(iter, MESSAGE_KEY_render_stats)) {
+    render_stats_dump();
+  }
+}
+
+void render_stats_launch(void) {
+  s_launch_ms = prv_now_ms();
+}
+
+void render_stats_startup(const char *stage) {
+  APP_LOG(APP_LOG_LEVEL_INFO, "startup: %s after %lu ms", stage,
+          (unsigned long)(prv_now_ms() - s_launch_ms));
+}
+
+void render_stats_init(void) {
+  s_inbox_handle = events_app_message_register_inbox_received(prv_inbox_received_handler, NULL);
+  events_app_message_request_outbox_size(dict_calc_buffer_size(1, sizeof(RenderStats)));
+}
+
+void render_stats_deinit(void) {
+  render_stats_dump();
+  events_app_message_unsubscribe(s_inbox_handle);
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <pebble.h>
+
+// Optional render instrumentation, built when RENDER_STATS is defined
+// (set VUELA_RENDER_STATS=1 when building). Counts redraws, draw calls and
+// time spent per plane, ticks, animation frames and redundant dirty
+// marks. The last frames are kept in a small ring; everything is logged
+// and sent to the phone every hour or when it asks for the "render_stats"
+// key. The time from launch to each stage of a cold start is logged too.
+
+typedef enum {
+  RENDER_PLANE_MARKS,
+  RENDER_PLANE_DAY,
+  RENDER_PLANE_CLOCK,
+  RENDER_PLANE_SECONDS,
+  RENDER_PLANE_COUNT
+} RenderPlane;
+
+#if defined(RENDER_STATS)
+
+void render_stats_init(void);
+void render_stats_deinit(void);
+void render_stats_begin(RenderPlane plane);
+void render_stats_end(RenderPlane plane);
+void render_stats_draw_call(void);
+void render_stats_tick(TimeUnits units_changed);
+void render_stats_animation_frame(void);
+void render_stats_dirty(bool changed);
+void render_stats_dump(void);
+void render_stats_launch(void);
+void render_stats_startup(const char *stage);
+
+#define RENDER_STATS_LAUNCH() render_stats_launch()
+#define RENDER_STATS_STARTUP(stage) render_stats_startup(stage)
+#define RENDER_STATS_BEGIN(plane) render_stats_begin(plane)
+#define RENDER_STATS_END(plane) render_stats_end(plane)
+#define RENDER_STATS_TICK(units_changed) render_stats_tick(units_changed)
+#define RENDER_STATS_ANIMATION_FRAME() render_stats_animation_frame()
+#define RENDER_STATS_DIRTY(changed) render_stats_dirty(changed)
+
+// count every primitive drawn by the files including this header
+#define graphics_draw_line(...) (render_stats_draw_call(), graphics_draw_line(__VA_ARGS__))
+#define graphics_draw_circle(...) (render_stats_draw_call(), graphics_draw_circle(__VA_ARGS__))
+#define graphics_draw_text(...) (render_stats_draw_call(), graphics_draw_text(__VA_ARGS__))
+#define graphics_draw_bitmap_in_rect(...) (render_stats_draw_call(), graphics_draw_bitmap_in_rect(__VA_ARGS__))
+#define graphics_fill_rect(...) (render_stats_draw_call(), graphics_fill_rect(__VA_ARGS__))
+#define graphics_fill_circle(...) (render_stats_draw_call(), graphics_fill_circle(__VA_ARGS__))
+#define graphics_fill_radial(...) (render_stats_draw_call(), graphics_fill_radial(__VA_ARGS__))
+
+#else
+
+#define render_stats_init()
+#define render_stats_deinit()
+#define RENDER_STATS_LAUNCH()
+#define RENDER_STATS_STARTUP(stage)
+#define RENDER_STATS_BEGIN(plane)
+#define RENDER_STATS_END(plane)
+#define RENDER_STATS_TICK(units_changed)
+#define RENDER_STATS_ANIMATION_FRAME()
+#define RENDER_STATS_DIRTY(changed) ((void)sizeof(changed))
+
+#endif
@@ -19,26 +19,133 @@
 */
 
 #include "watch_model.h"
+#include "clock_angles.h"
 #include "enamel.h"
+#include "render_stats.h"
 #include <pebble.h>
+#include "memory_stats.h"
 
 static EventHandle* s_evt_handler;
+// Ticks and taps are left alone until the intro is done and while an
+// animation is running, they are applied again once it finishes.
+static bool s_subscriptions_paused = true;
+// Running while the seconds hand is shown after a wrist flick
+static AppTimer *s_seconds_burst_timer;
+
+// Contexts come from a static pool: one for the running animation, one
+// for the next stage scheduled from its stopped handler, and one for a
+// preempted animation waiting for its teardown.
+#define CLOCK_ANIMATION_POOL_SIZE 3
+
+typedef enum {
+  CLOCK_ANIMATION_TO_NOW,
+  CLOCK_ANIMATION_TAP_OUT
+} ClockAnimationKind;
 
 typedef struct {
+  Animation *animation;
   ClockState start_state;
   ClockState end_state;
+  ClockAnimationKind kind;
+  bool in_use;
 } ClockAnimationContext;
 
-static int64_t prv_interpolate_int64_linear(int64_t from, int64_t to, const AnimationProgress progress) {
-    return from + ((progress * (to - from)) / ANIMATION_NORMALIZED_MAX);
+static ClockAnimationContext s_contexts[CLOCK_ANIMATION_POOL_SIZE];
+static ClockAnimationContext *s_running;
+
+// Frame scheduler: ticks, animation frames, seconds bursts and the power
+// policy post the new clock state or what else changed, and the view gets
+// a single frame with all of it on the next event loop turn. Animations
+// only run in the full power state, so their frames are not capped.
+
+static ClockState s_frame_state;
+static ClockState s_pending_state;
+static uint8_t s_pending_changes;
+static bool s_frames_started;
+static AppTimer *s_frame_timer;
+
+static uint8_t prv_clock_changes(const ClockState *from, const ClockState *to) {
+  uint8_t changes = 0;
+  if (from->minute_angle != to->minute_angle || from->hour_angle != to->hour_angle) {
+    changes |= CLOCK_CHANGE_HANDS;
+  }
+  if (from->second_angle != to->second_angle) {
+    changes |= CLOCK_CHANGE_SECONDS;
+  }
+  if (from->date != to->date) {
+    changes |= CLOCK_CHANGE_DATE;
+  }
+  return changes;
 }
 
-static ClockState prv_interpolate_clock_states(ClockState *start, ClockState *end, uint32_t progress) {
+static void prv_render_frame(void *data) {
+  s_frame_timer = NULL;
+  const uint8_t changes = s_pending_changes | prv_clock_changes(&s_frame_state, &s_pending_state);
+  RENDER_STATS_DIRTY(changes != 0);
+  s_pending_changes = 0;
+  s_frame_state = s_pending_state;
+  if (changes) {
+    watch_model_handle_frame(s_frame_state, changes);
+  }
+}
+
+static void prv_schedule_frame(void) {
+  if (s_frame_timer || !s_frames_started) {
+    return;
+  }
+  s_frame_timer = app_timer_register(0, prv_render_frame, NULL);
+}
+
+static void prv_post_state(ClockState state) {
+  s_pending_state = state;
+  prv_schedule_frame();
+}
+
+static void prv_post_changes(uint8_t changes) {
+  s_pending_changes |= changes;
+  prv_schedule_frame();
+}
+
+static ClockState prv_clock_state(struct tm *now, int ahead_ms) {
   return (ClockState) {
-    .minute_angle = prv_interpolate_int64_linear(start->minute_angle, end->minute_angle, progress),
-    .hour_angle = prv_interpolate_int64_linear(start->hour_angle, end->hour_angle, progress),
-    .second_angle = prv_interpolate_int64_linear(start->second_angle, end->second_angle, progress),
-    .date = prv_interpolate_int64_linear(start->date, end->date, progress),
+    .minute_angle = clock_angle_minute(now->tm_min),
+    .hour_angle = clock_angle_hour(now->tm_hour, now->tm_min),
+    .second_angle = clock_angle_second(now->tm_sec, ahead_ms),
+    .date = now->tm_mday,
+    .hour = now->tm_hour
+  };
+}
+
+// Ease in/out cubic, sampled every 1/32 of the animation (16.16 fixed point).
+static const uint32_t s_ease_in_out[] = {
+  0, 8, 64, 216, 512, 1000, 1728, 2744, 4096, 5832, 8000, 10648, 13824, 17576, 21952, 27000,
+  32768, 38536, 43584, 47960, 51712, 54888, 57536, 59704, 61440, 62792, 63808, 64536, 65024,
+  65320, 65472, 65528, 65536
+};
+
+static int32_t prv_ease(const AnimationProgress progress) {
+  if (progress >= ANIMATION_NORMALIZED_MAX) {
+    return s_ease_in_out[ARRAY_LENGTH(s_ease_in_out) - 1];
+  }
+  const int32_t index = progress >> 11;
+  const int32_t fraction = progress & 0x7ff;
+  const int32_t from = s_ease_in_out[index];
+  const int32_t to = s_ease_in_out[index + 1];
+  return from + (((to - from) * fraction) >> 11);
+}
+
+static int32_t prv_interpolate(int32_t from, int32_t to, int32_t eased) {
+  // sweeps can span more than a turn, so the product needs 64 bits
+  return from + (int32_t)(((int64_t)(to - from) * eased) >> 16);
+}
+
+static ClockState prv_interpolate_clock_states(ClockState *start, ClockState *end, AnimationProgress progress) {
+  const int32_t eased = prv_ease(progress);
+  return (ClockState) {
+    .minute_angle = prv_interpolate(start->minute_angle, end->minute_angle, eased),
+    .hour_angle = prv_interpolate(start->hour_angle, end->hour_angle, eased),
+    .second_angle = prv_interpolate(start->second_angle, end->second_angle, eased),
+    .date = prv_interpolate(start->date, end->date, eased),
     .hour = end->hour
   };
 }
@@ -49,68 +156,159 @@ static void prv_update_clock_animation(Animation *clock_animation,
   ClockState interpolated_state = prv_interpolate_clock_states(&clock_context->start_state,
                                                                &clock_context->end_state,
                                                                animation_progress);
-  watch_model_handle_clock_change(interpolated_state);
+  RENDER_STATS_ANIMATION_FRAME();
+  prv_post_state(interpolated_state);
 }
 
 static void prv_teardown_clock_animation(Animation *clock_animation) {
   ClockAnimationContext *clock_context = animation_get_context(clock_animation);
-  free(clock_context);
+  clock_context->in_use = false;
 }
 
 static void prv_handle_time_update(struct tm *tick_time, TimeUnits units_changed) {
-  if (units_changed & SECOND_UNIT) watch_model_handle_seconds_change(tick_time);
-  if (units_changed & MINUTE_UNIT) watch_model_handle_time_change(tick_time);
+  RENDER_STATS_TICK(units_changed);
+  MEMORY_STATS_TICK(units_changed);
+  if (units_changed & HOUR_UNIT) power_policy_update(tick_time->tm_hour);
+  prv_post_state(prv_clock_state(tick_time, 0));
+}
+
+static bool prv_seconds_burst_mode(void) {
+  const EnamelSettings *settings = enamel_get_settings();
+  return settings->display_seconds && settings->seconds_burst && power_policy_features_enabled();
+}
+
+// Whether the settings and the seconds burst ask for the seconds hand,
+// before the power state has its say
+static bool prv_seconds_wanted(void) {
+  if (!enamel_get_display_seconds()) {
+    return false;
+  }
+  return !enamel_get_seconds_burst() || s_seconds_burst_timer != NULL;
 }
 
-void update_subscriptions(int hour) {
-  TimeUnits units = enamel_get_display_seconds() ? (SECOND_UNIT | MINUTE_UNIT) : MINUTE_UNIT;
+bool watch_model_seconds_enabled(void) {
+  return prv_seconds_wanted() && power_policy_features_enabled();
+}
+
+void update_subscriptions(void) {
+  if (s_subscriptions_paused) {
+    return;
+  }
+  const bool features = power_policy_features_enabled();
+  TimeUnits units = watch_model_seconds_enabled() ? (SECOND_UNIT | MINUTE_UNIT) : MINUTE_UNIT;
   tick_timer_service_subscribe(units, prv_handle_time_update);
-  if (enamel_get_tap_to_animate() && !battery_saver_enabled(hour))
+  if ((enamel_get_tap_to_animate() && features) || prv_seconds_burst_mode())
       accel_tap_service_subscribe(accel_tap_handler);
   else
       accel_tap_service_unsubscribe();
 }
 
+static void prv_seconds_burst_ended(void *data) {
+  s_seconds_burst_timer = NULL;
+  update_subscriptions();
+  prv_post_changes(CLOCK_CHANGE_SECONDS_VISIBLE);
+}
+
+// Shows the seconds hand and ticks every second for a while, a flick
+// during the burst extends it.
+void watch_model_start_seconds_burst(void) {
+  if (!prv_seconds_burst_mode()) {
+    return;
+  }
+  const uint32_t duration = enamel_get_seconds_burst_duration() * 1000;
+  if (s_seconds_burst_timer) {
+    app_timer_reschedule(s_seconds_burst_timer, duration);
+    return;
+  }
+  s_seconds_burst_timer = app_timer_register(duration, prv_seconds_burst_ended, NULL);
+  update_subscriptions();
+  // only minutes were ticking, the hand has to start from the current second
+  const time_t t = time(NULL);
+  ClockState state = s_pending_state;
+  state.second_angle = clock_angle_second(localtime(&t)->tm_sec, 0);
+  prv_post_state(state);
+  prv_post_changes(CLOCK_CHANGE_SECONDS_VISIBLE);
+}
+
 static void prv_finish_animation(Animation *animation, bool finished, void *context) {
   const time_t t = time(NULL);
   struct tm *now = localtime(&t);
-  prv_handle_time_update(now, SECOND_UNIT);
-  update_subscriptions(now->tm_hour);
+  s_subscriptions_paused = false;
+  power_policy_update(now->tm_hour);
+  prv_post_state(prv_clock_state(now, 0));
+  update_subscriptions();
+  MEMORY_STATS_SAMPLE("animation end");
 }
 
-static Animation *prv_make_clock_animation(int duration, int delay, ClockState start_state, AnimationCurve curve) {
-  Animation *clock_animation = animation_create();
+static ClockState prv_state_after(int duration, int delay) {
+  time_t tm = time(NULL);
+  return prv_clock_state(localtime(&tm), duration + delay);
+}
+
+int32_t animation_direction(void) {
+    return (rand()%2) ? -TRIG_MAX_ANGLE : 0;
+}
+
+int32_t tap_angle(void) {
+    int angles[] = { 0, 180, 270 };
+    return CLOCK_ANGLE_DEGREES(angles[rand()%3]);
+}
+
+static void prv_clock_animation_stopped(Animation *animation, bool finished, void *context);
+
+// Starts a clock animation, preempting the running one: its stopped
+// handler is ignored and the new animation starts from the current state.
+static void prv_start_clock_animation(ClockAnimationKind kind, int duration, int delay,
+                                      ClockState start_state, ClockState end_state) {
+  ClockAnimationContext *clock_context = NULL;
+  for (int i = 0; i < CLOCK_ANIMATION_POOL_SIZE; i++) {
+    if (!s_contexts[i].in_use) {
+      clock_context = &s_contexts[i];
+      break;
+    }
+  }
+  if (s_running) {
+    Animation *preempted = s_running->animation;
+    s_running = NULL;
+    animation_unschedule(preempted);
+  }
+  if (!clock_context) {
+    prv_finish_animation(NULL, false, NULL);
+    return;
+  }
   static const AnimationImplementation animation_implementation = {
     .update = prv_update_clock_animation,
     .teardown = prv_teardown_clock_animation
   };
+  Animation *clock_animation = animation_create();
   animation_set_implementation(clock_animation, &animation_implementation);
   animation_set_duration(clock_animation, duration);
   animation_set_delay(clock_animation, delay);
-  animation_set_curve(clock_animation, curve);
-  ClockAnimationContext *clock_context = malloc(sizeof(*clock_context));
-  clock_context->start_state = start_state;
-  time_t tm = time(NULL);
-  struct tm *now = localtime(&tm);
-  clock_context->end_state = (ClockState) {
-    .minute_angle = now->tm_min * 6,
-    .hour_angle = (now->tm_hour%12)*30 + now->tm_min*.48,
-    .second_angle = (now->tm_sec + (duration+delay)*.001)*6,
-    .date = now->tm_mday,
-    .hour = now->tm_hour
+  animation_set_curve(clock_animation, AnimationCurveLinear);
+  *clock_context = (ClockAnimationContext) {
+    .animation = clock_animation,
+    .start_state = start_state,
+    .end_state = end_state,
+    .kind = kind,
+    .in_use = true
   };
   animation_set_handlers(clock_animation, (AnimationHandlers) {
-    .stopped = prv_finish_animation
+    .stopped = prv_clock_animation_stopped
   }, clock_context);
-  return clock_animation;
+  s_subscriptions_paused = true;
+  s_running = clock_context;
+  animation_schedule(clock_animation);
+  MEMORY_STATS_SAMPLE("animation start");
 }
 
-int animation_direction(void) {
-    return (rand()%2) ? -360 : 0;
-}
-
-static void finish_first_tap_animation(Animation *animation, bool finished, void *context) {
-    ClockAnimationContext *clock_context = (ClockAnimationContext *)context;
+static void prv_clock_animation_stopped(Animation *animation, bool finished, void *context) {
+  ClockAnimationContext *clock_context = (ClockAnimationContext *)context;
+  if (clock_context != s_running) {
+    // preempted, the animation that replaced it owns the clock now
+    return;
+  }
+  s_running = NULL;
+  if (finished && clock_context->kind == CLOCK_ANIMATION_TAP_OUT) {
     ClockState end_state = clock_context->end_state;
     ClockState start_state = (ClockState) {
         .minute_angle = end_state.minute_angle + animation_direction(),
@@ -119,57 +317,39 @@ static void finish_first_tap_animation(Animation *animation, bool finished, void
 	.date = end_state.date,
 	.hour = end_state.hour
     };
-    Animation *const tap_animation = prv_make_clock_animation(1500, 200, start_state, AnimationCurveEaseInOut);
-    animation_schedule(tap_animation);
-}
-
-int tap_angle(void) {
-    int angles[] = { 0, 180, 270 };
-    return angles[rand()%3];
-}
-
-static Animation *make_first_tap_animation(int duration, ClockState start_state, AnimationCurve curve) {
-  Animation *clock_animation = animation_create();
-  static const AnimationImplementation animation_implementation = {
-    .update = prv_update_clock_animation,
-    .teardown = prv_teardown_clock_animation
-  };
-  animation_set_implementation(clock_animation, &animation_implementation);
-  animation_set_duration(clock_animation, duration);
-  animation_set_delay(clock_animation, 0);
-  animation_set_curve(clock_animation, curve);
-  ClockAnimationContext *clock_context = malloc(sizeof(*clock_context));
-  clock_context->start_state = start_state;
-  time_t tm = time(NULL);
-  struct tm *now = localtime(&tm);
-  int angle = tap_angle();
-  clock_context->end_state = (ClockState) {
-    .minute_angle = angle,
-    .hour_angle = angle,
-    .second_angle = angle,
-    .date = now->tm_mday,
-    .hour = now->tm_hour
-  };
-  animation_set_handlers(clock_animation, (AnimationHandlers) {
-    .stopped = finish_first_tap_animation
-  }, clock_context);
-  return clock_animation;
+    prv_start_clock_animation(CLOCK_ANIMATION_TO_NOW, 1500, 200, start_state,
+                              prv_state_after(1500, 200));
+  }
+  else {
+    prv_finish_animation(animation, finished, context);
+  }
 }
 
 void schedule_tap_animation(ClockState current_state) {
     //APP_LOG(APP_LOG_LEVEL_DEBUG_VERBOSE, "TAP!");
-    Animation *const tap_animation = make_first_tap_animation(1000, current_state, AnimationCurveEaseInOut);
+    time_t tm = time(NULL);
+    struct tm *now = localtime(&tm);
+    int32_t angle = tap_angle();
+    ClockState end_state = (ClockState) {
+      .minute_angle = angle,
+      .hour_angle = angle,
+      .second_angle = angle,
+      .date = now->tm_mday,
+      .hour = now->tm_hour
+    };
+    // the tap subscription stays, a new tap retargets the running animation
     tick_timer_service_unsubscribe();
-    accel_tap_service_unsubscribe();
-    animation_schedule(tap_animation);
+    prv_start_clock_animation(CLOCK_ANIMATION_TAP_OUT, 1000, 0, current_state, end_state);
 }
 
 void watch_model_start_intro(ClockState start_state) {
-    if (enamel_get_intro_enabled() && !battery_saver_enabled(start_state.hour)) {
-        Animation *const clock_animation = prv_make_clock_animation(enamel_get_intro_duration(), 0,
-                                                                    start_state,
-								    AnimationCurveEaseInOut);
-        animation_schedule(clock_animation);
+    s_frame_state = start_state;
+    s_pending_state = start_state;
+    s_frames_started = true;
+    if (enamel_get_intro_enabled() && power_policy_features_enabled()) {
+        int duration = enamel_get_intro_duration();
+        prv_start_clock_animation(CLOCK_ANIMATION_TO_NOW, duration, 0, start_state,
+                                  prv_state_after(duration, 0));
     }
     else {
         prv_finish_animation(NULL, true, NULL);
@@ -177,13 +357,39 @@ void watch_model_start_intro(ClockState start_state) {
 }
 
 static void prv_msg_received_handler(void *context) {
-  watch_model_handle_config_change();
+  watch_model_handle_config_change(enamel_get_changed_settings());
 }
 
 void watch_model_init(void) {
   s_evt_handler = enamel_settings_received_subscribe(prv_msg_received_handler, NULL);
 }
 
+// Only what differs between the two states is repainted: the level of
+// detail, which drops the cached dial, and the seconds hand. States often
+// share a level of detail, e.g. with full detail in the battery saver.
+void watch_model_handle_power_change(PowerState state, PowerState previous) {
+  update_subscriptions();
+  uint8_t changes = 0;
+  if (power_policy_state_render_quality(state) != power_policy_state_render_quality(previous)) {
+    changes |= CLOCK_CHANGE_QUALITY;
+  }
+  if (prv_seconds_wanted() &&
+      power_policy_state_features_enabled(state) != power_policy_state_features_enabled(previous)) {
+    changes |= CLOCK_CHANGE_SECONDS_VISIBLE;
+  }
+  if (changes) {
+    prv_post_changes(changes);
+  }
+}
+
 void watch_model_deinit(void) {
   enamel_settings_received_unsubscribe(s_evt_handler);
+  if (s_frame_timer) {
+    app_timer_cancel(s_frame_timer);
+    s_frame_timer = NULL;
+  }
+  if (s_seconds_burst_timer) {
+    app_timer_cancel(s_seconds_burst_timer);
+    s_seconds_burst_timer = NULL;
+  }
 }
@@ -18,6 +18,7 @@
 */
 
 #include <pebble.h>
+#include "power_policy.h"
 
 #define CLOCK_ANIMATION_DELAY 0
 
@@ -29,15 +30,27 @@ typedef struct {
   int hour;
 } ClockState;
 
+// What a frame changed, for the view to pick the planes to redraw
+typedef enum {
+  CLOCK_CHANGE_HANDS = 1 << 0,
+  CLOCK_CHANGE_SECONDS = 1 << 1,
+  CLOCK_CHANGE_DATE = 1 << 2,
+  // the seconds hand was shown or hidden
+  CLOCK_CHANGE_SECONDS_VISIBLE = 1 << 3,
+  // the render quality of the power state may differ
+  CLOCK_CHANGE_QUALITY = 1 << 4
+} ClockChange;
+
 void watch_model_start_intro(ClockState start_state);
 void watch_model_init(void);
 void watch_model_deinit(void);
 
-void watch_model_handle_clock_change(ClockState state);
-void watch_model_handle_time_change(struct tm *tick_time);
-void watch_model_handle_seconds_change(struct tm *tick_time);
-void watch_model_handle_config_change(void);
+// Called at most once per event loop turn with everything that changed
+void watch_model_handle_frame(ClockState state, uint8_t changes);
+void watch_model_handle_config_change(uint32_t changed);
+void watch_model_handle_power_change(PowerState state, PowerState previous);
+void watch_model_start_seconds_burst(void);
+bool watch_model_seconds_enabled(void);
 void schedule_tap_animation(ClockState current_state);
 void accel_tap_handler(AccelAxisType axis, int32_t direction);
-void update_subscriptions(int hour);
-bool battery_saver_enabled(int hour);
+void update_subscriptions(void);
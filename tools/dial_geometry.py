@@ -0,0 +1,197 @@
+"""Generates the per-platform dial geometry tables (dial_tables.c/.h).
+
+Every ring of the dial is a circle fitted in a frame that is a fixed
+fraction of the screen, so for a given screen size all the tick ends,
+label centers and hand tips are constants. The points are computed the same
+way the firmware's gpoint_from_polar does, in 1/8 pixel fixed point.
+
+Angles are emitted in TRIG_MAX_ANGLE units so lookups need no conversion.
+The hour hand gets a half degree table since it moves half a degree a minute.
+The hand tables are most of the data, so they are left out on platforms with
+little RAM, where the hands are computed with gpoint_from_polar instead.
+"""
+
+import json
+import math
+
+TRIG_MAX_ANGLE = 0x10000
+TRIG_MAX_RATIO = 0xffff
+
+SCREEN_SIZES = {
+    'aplite': (144, 168),
+    'basalt': (144, 168),
+    'diorite': (144, 168),
+    'chalk': (180, 180),
+    'emery': (200, 228),
+}
+
+# name, frame size in 1/1000 of the screen, frame offset, first angle in degrees, steps
+RINGS = [
+    ('TICK_OUTER', 970, (0, 0), 0, 60),
+    ('TICK_INNER', 900, (0, 0), 0, 60),
+    ('MINUTE_LABEL', 780, (0, -1), 0, 12),
+    ('HOUR_LABEL', 460, (1, 0), 0, 12),
+    ('DATE', 660, (0, 0), 83, 1),
+    ('SECOND_HAND', 960, (0, 0), 0, 360),
+    ('MINUTE_HAND', 920, (0, 0), 0, 360),
+    ('HOUR_HAND', 500, (0, 0), 0, 720),
+    ('HAND_BASE', 190, (0, 0), 0, 360),
+]
+
+HAND_RINGS = ('SECOND_HAND', 'MINUTE_HAND', 'HOUR_HAND', 'HAND_BASE')
+
+# the app binary is loaded in RAM, 3.5K for the hand tables out of 24K
+NO_HAND_TABLES = ('aplite',)
+
+
+def ring_frame(width, height, scale, offset):
+    w = width * scale // 1000
+    h = height * scale // 1000
+    return ((width - w) // 2 + offset[0], (height - h) // 2 + offset[1], w, h)
+
+
+def trig_lookup(angle, fn):
+    return int(round(fn(2 * math.pi * angle / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO))
+
+
+def c_div(a, b):
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b >= 0) else -q
+
+
+def trig_angle(degrees):
+    return degrees * TRIG_MAX_ANGLE // 360
+
+
+def polar_point(frame, angle):
+    x, y, w, h = frame
+    center_x = x * 8 + (w - 1) * 4
+    center_y = y * 8 + (h - 1) * 4
+    radius = (min(w, h) - 1) * 4
+    px = center_x + c_div(trig_lookup(angle, math.sin) * radius, TRIG_MAX_RATIO)
+    py = center_y - c_div(trig_lookup(angle, math.cos) * radius, TRIG_MAX_RATIO)
+    return (px >> 3, py >> 3)
+
+
+def ring_points(width, height, ring):
+    name, scale, offset, first, steps = ring
+    frame = ring_frame(width, height, scale, offset)
+    first = trig_angle(first)
+    return [polar_point(frame, first + i * TRIG_MAX_ANGLE // steps) for i in range(steps)]
+
+
+def platform_define(platforms):
+    return ' || '.join('defined(PBL_PLATFORM_%s)' % p.upper() for p in platforms)
+
+
+def render_header():
+    lines = [
+        '/**',
+        ' * This file was generated by tools/dial_geometry.py',
+        ' */',
+        '',
+        '#ifndef DIAL_TABLES_H',
+        '#define DIAL_TABLES_H',
+        '',
+        '#include <pebble.h>',
+        '',
+        'typedef enum {',
+    ]
+    lines += ['  DIAL_RING_%s,' % ring[0] for ring in RINGS]
+    lines += [
+        '  DIAL_RING_COUNT',
+        '} DialRing;',
+        '',
+        'typedef struct {',
+        '  uint8_t x;',
+        '  uint8_t y;',
+        '} DialPoint;',
+        '',
+        'typedef struct {',
+        '  int16_t scale;',
+        '  int8_t offset_x;',
+        '  int8_t offset_y;',
+        '  int32_t first_angle;',
+        '  int16_t steps;',
+        '  // NULL when the ring is not tabulated on this platform',
+        '  const DialPoint *points;',
+        '} DialRingSpec;',
+        '',
+        '// screen size the tables were computed for',
+        'extern const GSize dial_tables_size;',
+        'extern const DialRingSpec dial_rings[DIAL_RING_COUNT];',
+        '',
+        '#endif',
+        '',
+    ]
+    return '\n'.join(lines)
+
+
+def ring_has_table(ring, hand_tables):
+    return hand_tables or ring[0] not in HAND_RINGS
+
+
+def render_source(platforms):
+    by_size = {}
+    for platform in platforms:
+        key = SCREEN_SIZES[platform] + (platform not in NO_HAND_TABLES,)
+        by_size.setdefault(key, []).append(platform)
+
+    lines = [
+        '/**',
+        ' * This file was generated by tools/dial_geometry.py',
+        ' */',
+        '',
+        '#include "dial_tables.h"',
+        '',
+    ]
+    for key in sorted(by_size):
+        width, height, hand_tables = key
+        lines.append('#if %s' % platform_define(sorted(by_size[key])))
+        lines.append('')
+        lines.append('const GSize dial_tables_size = { %d, %d };' % (width, height))
+        for ring in RINGS:
+            if not ring_has_table(ring, hand_tables):
+                continue
+            points = ring_points(width, height, ring)
+            lines.append('')
+            lines.append('static const DialPoint s_%s[%d] = {' % (ring[0].lower(), len(points)))
+            for i in range(0, len(points), 8):
+                row = points[i:i + 8]
+                lines.append('  ' + ' '.join('{%d, %d},' % p for p in row))
+            lines.append('};')
+        lines.append('')
+        lines.append('const DialRingSpec dial_rings[DIAL_RING_COUNT] = {')
+        for ring in RINGS:
+            name, scale, offset, first, steps = ring
+            points = 's_%s' % name.lower() if ring_has_table(ring, hand_tables) else 'NULL'
+            lines.append('  [DIAL_RING_%s] = { %d, %d, %d, %d, %d, %s },'
+                         % (name, scale, offset[0], offset[1], trig_angle(first), steps,
+                            points))
+        lines.append('};')
+        lines.append('')
+        lines.append('#endif')
+        lines.append('')
+    return '\n'.join(lines)
+
+
+def generate(package_file='package.json', output_dir='.'):
+    with open(package_file) as f:
+        platforms = json.load(f)['pebble']['targetPlatforms']
+    with open('%s/dial_tables.h' % output_dir, 'w') as f:
+        f.write(render_header())
+    with open('%s/dial_tables.c' % output_dir, 'w') as f:
+        f.write(render_source(platforms))
+
+
+def dial_geometry(task):
+    generate(package_file=task.inputs[0].abspath(), output_dir=task.generator.bld.bldnode.abspath())
+
+
+if __name__ == '__main__':
+    import argparse
+    parser = argparse.ArgumentParser(description='Generates the dial geometry tables')
+    parser.add_argument('--package', action='store', default='package.json', help='Path to package.json')
+    parser.add_argument('--folder', action='store', default='.', help='Generation folder')
+    result = parser.parse_args()
+    generate(package_file=result.package, output_dir=result.folder)
@@ -0,0 +1,59 @@
+"""Generates the headers the SDK build would give the host build.
+
+message_keys.auto.h and resource_ids.auto.h come from package.json like
+in the waf build: message keys numbered from 10000, resources from 1 in
+the order they are listed. resources.auto.c lists where each resource is
+and, for fonts, the pixel size the SDK takes from the end of its name.
+"""
+
+import json
+import os
+import re
+
+MESSAGE_KEY_BASE = 10000
+
+
+def message_keys(package):
+    lines = ['#pragma once', '']
+    for index, key in enumerate(package['pebble']['messageKeys']):
+        lines.append('#define MESSAGE_KEY_%s %d' % (key.split('[')[0], MESSAGE_KEY_BASE + index))
+    return '\n'.join(lines) + '\n'
+
+
+def resource_ids(media):
+    lines = ['#pragma once', '']
+    for index, resource in enumerate(media):
+        lines.append('#define RESOURCE_ID_%s %d' % (resource['name'], index + 1))
+    return '\n'.join(lines) + '\n'
+
+
+def resources(media, resources_folder):
+    lines = ['#include "host_sdk.h"', '', 'const struct HostResource host_resources[] = {']
+    for resource in media:
+        size = re.search(r'_(\d+)$', resource['name']) if resource['type'] == 'font' else None
+        path = os.path.abspath(os.path.join(resources_folder, resource['file']))
+        lines.append('  { %s, %d },' % (json.dumps(path), int(size.group(1)) if size else 0))
+    lines.append('};')
+    lines.append('')
+    lines.append('const int host_resource_count = ARRAY_LENGTH(host_resources);')
+    return '\n'.join(lines) + '\n'
+
+
+def write(folder, name, content):
+    with open(os.path.join(folder, name), 'w') as f:
+        f.write(content)
+
+
+if __name__ == '__main__':
+    import argparse
+    parser = argparse.ArgumentParser(description='Generates the SDK headers of the host build')
+    parser.add_argument('--package', action='store', default='package.json', help='Path to package.json')
+    parser.add_argument('--folder', action='store', default='.', help='Generation folder')
+    args = parser.parse_args()
+    with open(args.package) as f:
+        package = json.load(f)
+    media = package['pebble']['resources']['media']
+    resources_folder = os.path.join(os.path.dirname(os.path.abspath(args.package)), 'resources')
+    write(args.folder, 'message_keys.auto.h', message_keys(package))
+    write(args.folder, 'resource_ids.auto.h', resource_ids(media))
+    write(args.folder, 'resources.auto.c', resources(media, resources_folder))
@@ -0,0 +1,200 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "host.h"
+#include "host_stats.h"
+#include "watch_model.h"
+#include "clock_angles.h"
+#include "enamel.h"
+
+// Draw cost of each plane on this platform: launches the watchface, lets
+// the cold start and the intro play out, then for each render quality
+// (picked with the battery level) times a minute of ticks and repeated
+// redraws of the hands, the whole dial and the date. Reports frames,
+// primitives and frame buffer captures per frame and the time per frame
+// spent in draw_marks, draw_day, draw_clock and draw_seconds.
+//
+//   bench [--csv] [--no-header] [--repeat N] [--settings HEX] [--verbose]
+//
+// --settings sends a message from tools/host/settings_message.py first.
+
+#define LAUNCH_TIME 1710670237 // 2024-03-17 10:10:37 UTC
+#define STARTUP_MS 5000
+#define SETTLE_MS 5000
+
+typedef struct {
+  const char *name;
+  uint8_t charge_percent;
+} Tier;
+
+static const Tier s_tiers[] = {
+  { "full", 100 },
+  { "reduced", 15 },
+  { "minimal", 5 },
+};
+
+static bool s_csv;
+static bool s_header = true;
+static int s_repeat = 50;
+static uint8_t s_settings[256];
+static uint16_t s_settings_size;
+
+static ClockState prv_current_state(void) {
+  time_t now = time(NULL);
+  struct tm *tick_time = localtime(&now);
+  return (ClockState) {
+    .minute_angle = clock_angle_minute(tick_time->tm_min),
+    .hour_angle = clock_angle_hour(tick_time->tm_hour, tick_time->tm_min),
+    .second_angle = clock_angle_second(tick_time->tm_sec, 0),
+    .date = tick_time->tm_mday,
+    .hour = tick_time->tm_hour,
+  };
+}
+
+static void prv_redraw_hands(void *data) {
+  watch_model_handle_frame(prv_current_state(), CLOCK_CHANGE_HANDS);
+}
+
+static void prv_redraw_dial(void *data) {
+  watch_model_handle_config_change(ENAMEL_CHANGED_CLOCK_BG_COLOR);
+}
+
+static void prv_redraw_date(void *data) {
+  watch_model_handle_frame(prv_current_state(), CLOCK_CHANGE_DATE);
+}
+
+static void prv_run_ticks(void) {
+  host_run_for(60 * 1000);
+}
+
+static void prv_repeat(void (*callback)(void *data)) {
+  for (int i = 0; i < s_repeat; i++) {
+    host_call(callback, NULL);
+  }
+}
+
+static void prv_run_hands(void) {
+  prv_repeat(prv_redraw_hands);
+}
+
+static void prv_run_dial(void) {
+  prv_repeat(prv_redraw_dial);
+}
+
+static void prv_run_date(void) {
+  prv_repeat(prv_redraw_date);
+}
+
+typedef struct {
+  const char *name;
+  void (*run)(void);
+} Scenario;
+
+static const Scenario s_scenarios[] = {
+  { "seconds", prv_run_ticks },
+  { "hands", prv_run_hands },
+  { "dial", prv_run_dial },
+  { "date", prv_run_date },
+};
+
+static void prv_print_header(void) {
+  if (s_csv) {
+    printf("platform,quality,scenario,plane,frames,redraws,primitives_per_frame,"
+           "captures_per_frame,us_per_frame\n");
+  }
+  else {
+    printf("%-8s %-8s %-8s %-8s %7s %8s %11s %9s %9s\n", "platform", "quality", "scenario",
+           "plane", "frames", "redraws", "prims/frame", "caps/frame", "us/frame");
+  }
+}
+
+static void prv_print_row(const char *tier, const char *scenario, const char *plane,
+                          uint32_t frames, const HostPlaneStats *stats) {
+  const double per_frame = frames ? 1.0 / frames : 0;
+  const char *format = s_csv ? "%s,%s,%s,%s,%lu,%lu,%.2f,%.2f,%.2f\n"
+                             : "%-8s %-8s %-8s %-8s %7lu %8lu %11.2f %9.2f %9.2f\n";
+  printf(format, host_platform(), tier, scenario, plane, (unsigned long)frames,
+         (unsigned long)stats->redraws, stats->draw_calls * per_frame,
+         stats->captures * per_frame, stats->ns * per_frame / 1000.0);
+}
+
+static void prv_measure(const Tier *tier, const Scenario *scenario) {
+  host_render_stats_reset();
+  host_counters_reset();
+  scenario->run();
+  const uint32_t frames = host_counters()->frames;
+  const HostRenderStats *stats = host_render_stats();
+  HostPlaneStats total = { 0 };
+  for (int plane = 0; plane < RENDER_PLANE_COUNT; plane++) {
+    prv_print_row(tier->name, scenario->name, host_plane_name(plane), frames,
+                  &stats->planes[plane]);
+    total.redraws += stats->planes[plane].redraws;
+    total.draw_calls += stats->planes[plane].draw_calls;
+    total.captures += stats->planes[plane].captures;
+    total.ns += stats->planes[plane].ns;
+  }
+  prv_print_row(tier->name, scenario->name, "all", frames, &total);
+}
+
+static void prv_bench(void) {
+  host_run_for(STARTUP_MS);
+  if (s_settings_size) {
+    host_receive_message(s_settings, s_settings_size);
+    host_run_until_idle(SETTLE_MS);
+  }
+  if (s_header) {
+    prv_print_header();
+  }
+  for (unsigned t = 0; t < ARRAY_LENGTH(s_tiers); t++) {
+    host_set_battery((BatteryChargeState) { .charge_percent = s_tiers[t].charge_percent });
+    host_run_until_idle(SETTLE_MS);
+    for (unsigned s = 0; s < ARRAY_LENGTH(s_scenarios); s++) {
+      prv_measure(&s_tiers[t], &s_scenarios[s]);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--csv") == 0) {
+      s_csv = true;
+    }
+    else if (strcmp(argv[i], "--no-header") == 0) {
+      s_header = false;
+    }
+    else if (strcmp(argv[i], "--verbose") == 0) {
+      host_set_verbose(true);
+    }
+    else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+      s_repeat = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--settings") == 0 && i + 1 < argc &&
+             host_parse_hex(argv[i + 1], s_settings, sizeof(s_settings), &s_settings_size)) {
+      i++;
+    }
+    else {
+      fprintf(stderr, "usage: %s [--csv] [--no-header] [--repeat N] [--settings HEX] "
+              "[--verbose]\n", argv[0]);
+      return 1;
+    }
+  }
+  host_init(LAUNCH_TIME, prv_bench);
+  host_launch();
+  return 0;
+}
@@ -0,0 +1,769 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "host_sdk.h"
+#include <pebble-events/pebble-events.h>
+
+// Event loop on the simulated clock. Ticks, animation frames, app timers
+// and system events are kept with the time they are due and dispatched
+// one by one in time order; at the same point in time ticks go first,
+// then animation frames, then timers in the order they were registered.
+// The window is drawn after every event, like the firmware draws after
+// each event of its loop when a layer is dirty. Only the services and the
+// pebble-events calls the watchface uses are implemented.
+
+#define MAX_HANDLERS 8
+
+static HostCounters s_counters;
+static bool s_count_changed_pixels;
+static uint64_t s_last_wakeup_ms = UINT64_MAX;
+
+const HostCounters *host_counters(void) {
+  return &s_counters;
+}
+
+HostCounters *host_counters_mutable(void) {
+  return &s_counters;
+}
+
+void host_counters_reset(void) {
+  memset(&s_counters, 0, sizeof(s_counters));
+  s_last_wakeup_ms = UINT64_MAX;
+}
+
+void host_count_changed_pixels(bool enable) {
+  s_count_changed_pixels = enable;
+}
+
+bool host_count_changed_pixels_enabled(void) {
+  return s_count_changed_pixels;
+}
+
+void host_wakeup(void) {
+  if (s_last_wakeup_ms != host_now_ms()) {
+    s_last_wakeup_ms = host_now_ms();
+    s_counters.wakeups++;
+  }
+}
+
+// Every event wakes the app up and may leave something to draw
+static void prv_event_done(void) {
+  s_counters.events++;
+  host_render_if_dirty();
+}
+
+void host_call(void (*callback)(void *data), void *data) {
+  host_wakeup();
+  callback(data);
+  prv_event_done();
+}
+
+// ---------------------------------------------------------------------------
+// Timers
+
+struct AppTimer {
+  uint64_t due_ms;
+  uint32_t seq;
+  AppTimerCallback callback;
+  void *data;
+  // system events don't count as app timers
+  bool system;
+  AppTimer *next;
+};
+
+static AppTimer *s_timers;
+static uint32_t s_timer_seq;
+
+static void prv_insert_timer(AppTimer *timer) {
+  AppTimer **link = &s_timers;
+  while (*link && ((*link)->due_ms < timer->due_ms ||
+                   ((*link)->due_ms == timer->due_ms && (*link)->seq < timer->seq))) {
+    link = &(*link)->next;
+  }
+  timer->next = *link;
+  *link = timer;
+}
+
+static bool prv_unlink_timer(AppTimer *timer) {
+  for (AppTimer **link = &s_timers; *link; link = &(*link)->next) {
+    if (*link == timer) {
+      *link = timer->next;
+      return true;
+    }
+  }
+  return false;
+}
+
+static AppTimer *prv_register(uint32_t delay_ms, AppTimerCallback callback, void *data,
+                              bool system) {
+  AppTimer *timer = calloc(1, sizeof(AppTimer));
+  if (!timer) {
+    return NULL;
+  }
+  *timer = (AppTimer) {
+    .due_ms = host_now_ms() + delay_ms,
+    .seq = s_timer_seq++,
+    .callback = callback,
+    .data = data,
+    .system = system,
+  };
+  prv_insert_timer(timer);
+  return timer;
+}
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+  return prv_register(timeout_ms, callback, callback_data, false);
+}
+
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms) {
+  if (!timer_handle || !prv_unlink_timer(timer_handle)) {
+    return false;
+  }
+  timer_handle->due_ms = host_now_ms() + new_timeout_ms;
+  timer_handle->seq = s_timer_seq++;
+  prv_insert_timer(timer_handle);
+  return true;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+  if (timer_handle && prv_unlink_timer(timer_handle)) {
+    free(timer_handle);
+  }
+}
+
+void host_schedule_system_event(uint32_t delay_ms, void (*callback)(void *data), void *data) {
+  prv_register(delay_ms, callback, data, true);
+}
+
+static void prv_fire_timer(void) {
+  AppTimer *timer = s_timers;
+  s_timers = timer->next;
+  if (!timer->system) {
+    s_counters.timers++;
+  }
+  const AppTimerCallback callback = timer->callback;
+  void *data = timer->data;
+  free(timer);
+  callback(data);
+}
+
+// ---------------------------------------------------------------------------
+// Ticks
+
+static TickHandler s_tick_handler;
+static TimeUnits s_tick_units;
+static uint64_t s_next_tick_ms;
+
+static uint32_t prv_tick_period_ms(TimeUnits units) {
+  if (units & SECOND_UNIT) {
+    return 1000;
+  }
+  if (units & MINUTE_UNIT) {
+    return 60 * 1000;
+  }
+  if (units & HOUR_UNIT) {
+    return 60 * 60 * 1000;
+  }
+  // days, months and years tick at midnight and are filtered on delivery
+  return 24 * 60 * 60 * 1000;
+}
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+  s_tick_handler = handler;
+  s_tick_units = tick_units;
+  const uint32_t period = prv_tick_period_ms(tick_units);
+  s_next_tick_ms = (host_now_ms() / period + 1) * period;
+}
+
+void tick_timer_service_unsubscribe(void) {
+  s_tick_handler = NULL;
+  s_tick_units = 0;
+}
+
+static TimeUnits prv_units_changed(const struct tm *tick_time) {
+  TimeUnits units = SECOND_UNIT;
+  if (tick_time->tm_sec == 0) {
+    units |= MINUTE_UNIT;
+    if (tick_time->tm_min == 0) {
+      units |= HOUR_UNIT;
+      if (tick_time->tm_hour == 0) {
+        units |= DAY_UNIT;
+        if (tick_time->tm_mday == 1) {
+          units |= MONTH_UNIT;
+          if (tick_time->tm_mon == 0) {
+            units |= YEAR_UNIT;
+          }
+        }
+      }
+    }
+  }
+  return units;
+}
+
+static void prv_fire_tick(void) {
+  s_next_tick_ms += prv_tick_period_ms(s_tick_units);
+  time_t now = time(NULL);
+  struct tm *tick_time = localtime(&now);
+  const TimeUnits units_changed = prv_units_changed(tick_time);
+  if (units_changed & s_tick_units) {
+    s_counters.ticks++;
+    s_tick_handler(tick_time, units_changed);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Animations
+
+struct Animation {
+  AnimationImplementation implementation;
+  AnimationHandlers handlers;
+  void *context;
+  uint32_t duration_ms;
+  uint32_t delay_ms;
+  AnimationCurve curve;
+  bool scheduled;
+  bool started;
+  uint64_t start_ms;
+  Animation *next;
+};
+
+// scheduled animations, in the order they were scheduled
+static Animation *s_animations;
+static uint64_t s_last_frame_ms;
+
+Animation *animation_create(void) {
+  Animation *animation = calloc(1, sizeof(Animation));
+  if (animation) {
+    animation->duration_ms = 250;
+    animation->curve = AnimationCurveDefault;
+  }
+  return animation;
+}
+
+bool animation_destroy(Animation *animation) {
+  if (!animation) {
+    return false;
+  }
+  animation_unschedule(animation);
+  free(animation);
+  return true;
+}
+
+bool animation_set_implementation(Animation *animation,
+                                  const AnimationImplementation *implementation) {
+  if (animation->scheduled) {
+    return false;
+  }
+  animation->implementation = *implementation;
+  return true;
+}
+
+bool animation_set_duration(Animation *animation, uint32_t duration_ms) {
+  if (animation->scheduled) {
+    return false;
+  }
+  animation->duration_ms = duration_ms;
+  return true;
+}
+
+bool animation_set_delay(Animation *animation, uint32_t delay_ms) {
+  if (animation->scheduled) {
+    return false;
+  }
+  animation->delay_ms = delay_ms;
+  return true;
+}
+
+bool animation_set_curve(Animation *animation, AnimationCurve curve) {
+  if (animation->scheduled) {
+    return false;
+  }
+  animation->curve = curve;
+  return true;
+}
+
+bool animation_set_handlers(Animation *animation, AnimationHandlers callbacks, void *context) {
+  if (animation->scheduled) {
+    return false;
+  }
+  animation->handlers = callbacks;
+  animation->context = context;
+  return true;
+}
+
+void *animation_get_context(Animation *animation) {
+  return animation->context;
+}
+
+bool animation_is_scheduled(Animation *animation) {
+  return animation && animation->scheduled;
+}
+
+bool animation_schedule(Animation *animation) {
+  if (!animation || animation->scheduled) {
+    return false;
+  }
+  animation->scheduled = true;
+  animation->started = false;
+  animation->start_ms = host_now_ms() + animation->delay_ms;
+  animation->next = NULL;
+  Animation **link = &s_animations;
+  while (*link) {
+    link = &(*link)->next;
+  }
+  *link = animation;
+  if (animation->implementation.setup) {
+    animation->implementation.setup(animation);
+  }
+  return true;
+}
+
+static void prv_unlink_animation(Animation *animation) {
+  for (Animation **link = &s_animations; *link; link = &(*link)->next) {
+    if (*link == animation) {
+      *link = animation->next;
+      break;
+    }
+  }
+  animation->scheduled = false;
+}
+
+// Finished or not, the SDK destroys animations once they stop
+static void prv_stop_animation(Animation *animation, bool finished) {
+  prv_unlink_animation(animation);
+  if (animation->handlers.stopped) {
+    animation->handlers.stopped(animation, finished, animation->context);
+  }
+  if (animation->implementation.teardown) {
+    animation->implementation.teardown(animation);
+  }
+  free(animation);
+}
+
+bool animation_unschedule(Animation *animation) {
+  if (!animation || !animation->scheduled) {
+    return false;
+  }
+  prv_stop_animation(animation, false);
+  return true;
+}
+
+static AnimationProgress prv_curve(AnimationCurve curve, AnimationProgress t) {
+  const int64_t max = ANIMATION_NORMALIZED_MAX;
+  switch (curve) {
+    case AnimationCurveEaseIn:
+      return t * (int64_t)t / max;
+    case AnimationCurveEaseOut:
+      return max - (max - t) * (max - t) / max;
+    case AnimationCurveEaseInOut:
+      if (t < max / 2) {
+        return 2 * (int64_t)t * t / max;
+      }
+      return max - 2 * (max - t) * (max - t) / max;
+    default:
+      return t;
+  }
+}
+
+static uint64_t prv_next_frame_ms(void) {
+  uint64_t next = UINT64_MAX;
+  for (Animation *animation = s_animations; animation; animation = animation->next) {
+    next = MIN(next, animation->start_ms);
+  }
+  if (next != UINT64_MAX && s_last_frame_ms) {
+    next = MAX(next, s_last_frame_ms + HOST_ANIMATION_FRAME_MS);
+  }
+  return next;
+}
+
+static bool prv_is_scheduled(const Animation *animation) {
+  for (Animation *scheduled = s_animations; scheduled; scheduled = scheduled->next) {
+    if (scheduled == animation) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Advances every animation that started, handlers may schedule and
+// unschedule others meanwhile
+static void prv_fire_animation_frame(void) {
+  const uint64_t now = host_now_ms();
+  s_last_frame_ms = now;
+  s_counters.animation_frames++;
+  Animation *due[32];
+  unsigned count = 0;
+  for (Animation *animation = s_animations; animation && count < ARRAY_LENGTH(due);
+       animation = animation->next) {
+    if (animation->start_ms <= now) {
+      due[count++] = animation;
+    }
+  }
+  for (unsigned i = 0; i < count; i++) {
+    Animation *animation = due[i];
+    if (!prv_is_scheduled(animation)) {
+      continue;
+    }
+    if (!animation->started) {
+      animation->started = true;
+      if (animation->handlers.started) {
+        animation->handlers.started(animation, animation->context);
+        if (!prv_is_scheduled(animation)) {
+          continue;
+        }
+      }
+    }
+    const uint64_t elapsed = now - animation->start_ms;
+    const bool finished = elapsed >= animation->duration_ms;
+    const AnimationProgress progress =
+        finished ? ANIMATION_NORMALIZED_MAX
+                 : (AnimationProgress)(elapsed * ANIMATION_NORMALIZED_MAX / animation->duration_ms);
+    if (animation->implementation.update) {
+      animation->implementation.update(animation, prv_curve(animation->curve, progress));
+    }
+    if (finished && prv_is_scheduled(animation)) {
+      prv_stop_animation(animation, true);
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Loop
+
+typedef enum {
+  EVENT_NONE,
+  EVENT_TICK,
+  EVENT_ANIMATION_FRAME,
+  EVENT_TIMER,
+} EventKind;
+
+static EventKind prv_next_event(uint64_t *due_ms) {
+  EventKind kind = EVENT_NONE;
+  *due_ms = UINT64_MAX;
+  if (s_tick_handler) {
+    kind = EVENT_TICK;
+    *due_ms = s_next_tick_ms;
+  }
+  const uint64_t frame = prv_next_frame_ms();
+  if (frame < *due_ms) {
+    kind = EVENT_ANIMATION_FRAME;
+    *due_ms = frame;
+  }
+  if (s_timers && s_timers->due_ms < *due_ms) {
+    kind = EVENT_TIMER;
+    *due_ms = s_timers->due_ms;
+  }
+  return kind;
+}
+
+static void prv_run(uint32_t ms, bool until_idle) {
+  const uint64_t end = host_now_ms() + ms;
+  while (true) {
+    if (until_idle && !s_timers && !s_animations) {
+      return;
+    }
+    uint64_t due;
+    const EventKind kind = prv_next_event(&due);
+    if (kind == EVENT_NONE || due > end) {
+      break;
+    }
+    if (due > host_now_ms()) {
+      host_set_now_ms(due);
+    }
+    host_wakeup();
+    switch (kind) {
+      case EVENT_TICK:
+        prv_fire_tick();
+        break;
+      case EVENT_ANIMATION_FRAME:
+        prv_fire_animation_frame();
+        break;
+      default:
+        prv_fire_timer();
+        break;
+    }
+    prv_event_done();
+  }
+  host_set_now_ms(end);
+}
+
+void host_run_for(uint32_t ms) {
+  prv_run(ms, false);
+}
+
+void host_run_until_idle(uint32_t max_ms) {
+  prv_run(max_ms, true);
+}
+
+// ---------------------------------------------------------------------------
+// Services
+
+static AccelTapHandler s_tap_handler;
+static BatteryChargeState s_battery = { .charge_percent = 100 };
+static BatteryStateHandler s_battery_handlers[MAX_HANDLERS];
+static AppFocusHandlers s_focus_handlers;
+static AppMessageInboxReceived s_inbox_handlers[MAX_HANDLERS];
+static void *s_inbox_contexts[MAX_HANDLERS];
+
+// Handles are the slot index plus one, so none is NULL
+static EventHandle prv_add_handler(void **slots, void *handler) {
+  for (int i = 0; i < MAX_HANDLERS; i++) {
+    if (!slots[i]) {
+      slots[i] = handler;
+      return (EventHandle)(intptr_t)(i + 1);
+    }
+  }
+  return NULL;
+}
+
+static void prv_remove_handler(void **slots, EventHandle handle) {
+  const intptr_t index = (intptr_t)handle - 1;
+  if (index >= 0 && index < MAX_HANDLERS) {
+    slots[index] = NULL;
+  }
+}
+
+void accel_tap_service_subscribe(AccelTapHandler handler) {
+  s_tap_handler = handler;
+}
+
+void accel_tap_service_unsubscribe(void) {
+  s_tap_handler = NULL;
+}
+
+void host_tap(void) {
+  if (!s_tap_handler) {
+    return;
+  }
+  host_wakeup();
+  s_counters.taps++;
+  s_tap_handler(ACCEL_AXIS_Y, 1);
+  prv_event_done();
+}
+
+BatteryChargeState battery_state_service_peek(void) {
+  return s_battery;
+}
+
+EventHandle events_battery_state_service_subscribe(BatteryStateHandler handler) {
+  return prv_add_handler((void **)s_battery_handlers, (void *)handler);
+}
+
+void events_battery_state_service_unsubscribe(EventHandle handle) {
+  prv_remove_handler((void **)s_battery_handlers, handle);
+}
+
+void host_set_battery(BatteryChargeState state) {
+  s_battery = state;
+  host_wakeup();
+  for (int i = 0; i < MAX_HANDLERS; i++) {
+    if (s_battery_handlers[i]) {
+      s_battery_handlers[i](state);
+    }
+  }
+  prv_event_done();
+}
+
+void app_focus_service_subscribe_handlers(AppFocusHandlers handlers) {
+  s_focus_handlers = handlers;
+}
+
+void app_focus_service_unsubscribe(void) {
+  s_focus_handlers = (AppFocusHandlers) { 0 };
+}
+
+void host_app_focus(bool in_focus) {
+  if (s_focus_handlers.will_focus) {
+    s_focus_handlers.will_focus(in_focus);
+  }
+  if (s_focus_handlers.did_focus) {
+    s_focus_handlers.did_focus(in_focus);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Unobstructed area
+
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+
+static UnobstructedAreaHandlers s_area_handlers[MAX_HANDLERS];
+static void *s_area_contexts[MAX_HANDLERS];
+static bool s_area_used[MAX_HANDLERS];
+static int16_t s_area_from;
+static int16_t s_area_to;
+
+EventHandle events_unobstructed_area_service_subscribe(UnobstructedAreaHandlers handlers,
+                                                       void *context) {
+  for (int i = 0; i < MAX_HANDLERS; i++) {
+    if (!s_area_used[i]) {
+      s_area_used[i] = true;
+      s_area_handlers[i] = handlers;
+      s_area_contexts[i] = context;
+      return (EventHandle)(intptr_t)(i + 1);
+    }
+  }
+  return NULL;
+}
+
+void events_unobstructed_area_service_unsubscribe(EventHandle handle) {
+  const intptr_t index = (intptr_t)handle - 1;
+  if (index >= 0 && index < MAX_HANDLERS) {
+    s_area_used[index] = false;
+  }
+}
+
+static void prv_area_update(Animation *animation, const AnimationProgress progress) {
+  host_set_obstruction_now(s_area_from + (s_area_to - s_area_from) * progress /
+                           ANIMATION_NORMALIZED_MAX);
+  for (int i = 0; i < MAX_HANDLERS; i++) {
+    if (s_area_used[i] && s_area_handlers[i].change) {
+      s_area_handlers[i].change(progress, s_area_contexts[i]);
+    }
+  }
+}
+
+static void prv_area_stopped(Animation *animation, bool finished, void *context) {
+  host_set_obstruction_now(s_area_to);
+  for (int i = 0; i < MAX_HANDLERS; i++) {
+    if (s_area_used[i] && s_area_handlers[i].did_change) {
+      s_area_handlers[i].did_change(s_area_contexts[i]);
+    }
+  }
+}
+
+// The Quick View slides in and out as an animation of the app, the way
+// the firmware runs it
+void host_set_obstruction(int16_t height) {
+  s_area_from = host_obstruction();
+  s_area_to = height;
+  if (s_area_from == s_area_to) {
+    return;
+  }
+  host_wakeup();
+  const GRect final_area = GRect(0, 0, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT - height);
+  for (int i = 0; i < MAX_HANDLERS; i++) {
+    if (s_area_used[i] && s_area_handlers[i].will_change) {
+      s_area_handlers[i].will_change(final_area, s_area_contexts[i]);
+    }
+  }
+  static const AnimationImplementation implementation = {
+    .update = prv_area_update,
+  };
+  Animation *animation = animation_create();
+  animation_set_implementation(animation, &implementation);
+  animation_set_duration(animation, HOST_OBSTRUCTION_MS);
+  animation_set_curve(animation, AnimationCurveEaseInOut);
+  animation_set_handlers(animation, (AnimationHandlers) { .stopped = prv_area_stopped }, NULL);
+  animation_schedule(animation);
+  prv_event_done();
+}
+
+#else
+
+// No Timeline Quick View on this platform
+void host_set_obstruction(int16_t height) {
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+// App messages
+
+static uint8_t s_outbox_buffer[512];
+static DictionaryIterator s_outbox;
+
+AppMessageResult events_app_message_open(void) {
+  return APP_MSG_OK;
+}
+
+void events_app_message_request_inbox_size(uint32_t size) {
+}
+
+void events_app_message_request_outbox_size(uint32_t size) {
+}
+
+EventHandle events_app_message_register_inbox_received(AppMessageInboxReceived received_callback,
+                                                       void *context) {
+  EventHandle handle = prv_add_handler((void **)s_inbox_handlers, (void *)received_callback);
+  if (handle) {
+    s_inbox_contexts[(intptr_t)handle - 1] = context;
+  }
+  return handle;
+}
+
+void events_app_message_unsubscribe(EventHandle handle) {
+  prv_remove_handler((void **)s_inbox_handlers, handle);
+}
+
+// Handlers may rewrite the tuples, like enamel maps the keys, so each one
+// reads its own copy
+void host_receive_message(const uint8_t *dictionary, uint16_t size) {
+  uint8_t *buffer = malloc(size);
+  DictionaryIterator iter;
+  host_wakeup();
+  s_counters.messages_in++;
+  for (int i = 0; i < MAX_HANDLERS; i++) {
+    if (s_inbox_handlers[i]) {
+      memcpy(buffer, dictionary, size);
+      dict_read_begin_from_buffer(&iter, buffer, size);
+      s_inbox_handlers[i](&iter, s_inbox_contexts[i]);
+    }
+  }
+  free(buffer);
+  prv_event_done();
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+  dict_write_begin(&s_outbox, s_outbox_buffer, sizeof(s_outbox_buffer));
+  *iterator = &s_outbox;
+  return APP_MSG_OK;
+}
+
+// Nothing is listening on the other side
+AppMessageResult app_message_outbox_send(void) {
+  dict_write_end(&s_outbox);
+  s_counters.messages_out++;
+  return APP_MSG_OK;
+}
+
+// ---------------------------------------------------------------------------
+
+void host_events_reset(void) {
+  while (s_timers) {
+    AppTimer *timer = s_timers;
+    s_timers = timer->next;
+    free(timer);
+  }
+  while (s_animations) {
+    Animation *animation = s_animations;
+    s_animations = animation->next;
+    free(animation);
+  }
+  s_last_frame_ms = 0;
+  s_tick_handler = NULL;
+  s_tick_units = 0;
+  s_tap_handler = NULL;
+  s_battery = (BatteryChargeState) { .charge_percent = 100 };
+  memset(s_battery_handlers, 0, sizeof(s_battery_handlers));
+  s_focus_handlers = (AppFocusHandlers) { 0 };
+  memset(s_inbox_handlers, 0, sizeof(s_inbox_handlers));
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+  memset(s_area_used, 0, sizeof(s_area_used));
+#endif
+}
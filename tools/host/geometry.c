@@ -0,0 +1,146 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <pebble.h>
+#include <math.h>
+
+// Points, rectangles and trigonometry, with the firmware's integer results.
+
+bool gpoint_equal(const GPoint * const point_a, const GPoint * const point_b) {
+  return point_a->x == point_b->x && point_a->y == point_b->y;
+}
+
+bool gsize_equal(const GSize *size_a, const GSize *size_b) {
+  return size_a->w == size_b->w && size_a->h == size_b->h;
+}
+
+bool grect_equal(const GRect * const rect_a, const GRect * const rect_b) {
+  return gpoint_equal(&rect_a->origin, &rect_b->origin) &&
+         gsize_equal(&rect_a->size, &rect_b->size);
+}
+
+bool grect_is_empty(const GRect * const rect) {
+  return rect->size.w == 0 || rect->size.h == 0;
+}
+
+void grect_standardize(GRect *rect) {
+  if (rect->size.w < 0) {
+    rect->origin.x += rect->size.w;
+    rect->size.w = -rect->size.w;
+  }
+  if (rect->size.h < 0) {
+    rect->origin.y += rect->size.h;
+    rect->size.h = -rect->size.h;
+  }
+}
+
+void grect_clip(GRect * const rect_to_clip, const GRect * const rect_clipper) {
+  GRect clipper = *rect_clipper;
+  grect_standardize(rect_to_clip);
+  grect_standardize(&clipper);
+  int x0 = MAX(rect_to_clip->origin.x, clipper.origin.x);
+  int y0 = MAX(rect_to_clip->origin.y, clipper.origin.y);
+  int x1 = MIN(rect_to_clip->origin.x + rect_to_clip->size.w, clipper.origin.x + clipper.size.w);
+  int y1 = MIN(rect_to_clip->origin.y + rect_to_clip->size.h, clipper.origin.y + clipper.size.h);
+  *rect_to_clip = GRect(x0, y0, MAX(x1 - x0, 0), MAX(y1 - y0, 0));
+}
+
+bool grect_contains_point(const GRect *rect, const GPoint *point) {
+  return point->x >= rect->origin.x && point->x < rect->origin.x + rect->size.w &&
+         point->y >= rect->origin.y && point->y < rect->origin.y + rect->size.h;
+}
+
+GPoint grect_center_point(const GRect *rect) {
+  return GPoint(rect->origin.x + rect->size.w / 2, rect->origin.y + rect->size.h / 2);
+}
+
+GRect grect_crop(GRect rect, const int32_t crop_size_px) {
+  return grect_inset(rect, GEdgeInsets(crop_size_px));
+}
+
+GRect grect_inset(GRect rect, GEdgeInsets insets) {
+  grect_standardize(&rect);
+  const int w = rect.size.w - insets.left - insets.right;
+  const int h = rect.size.h - insets.top - insets.bottom;
+  if (w < 0 || h < 0) {
+    return GRectZero;
+  }
+  return GRect(rect.origin.x + insets.left, rect.origin.y + insets.top, w, h);
+}
+
+void grect_align(GRect *rect, const GRect *inside_rect, const GAlign alignment, const bool clip) {
+  const int dw = inside_rect->size.w - rect->size.w;
+  const int dh = inside_rect->size.h - rect->size.h;
+  int x = inside_rect->origin.x + dw / 2;
+  int y = inside_rect->origin.y + dh / 2;
+  switch (alignment) {
+    case GAlignTopLeft: case GAlignLeft: case GAlignBottomLeft:
+      x = inside_rect->origin.x;
+      break;
+    case GAlignTopRight: case GAlignRight: case GAlignBottomRight:
+      x = inside_rect->origin.x + dw;
+      break;
+    default:
+      break;
+  }
+  switch (alignment) {
+    case GAlignTopLeft: case GAlignTop: case GAlignTopRight:
+      y = inside_rect->origin.y;
+      break;
+    case GAlignBottomLeft: case GAlignBottom: case GAlignBottomRight:
+      y = inside_rect->origin.y + dh;
+      break;
+    default:
+      break;
+  }
+  rect->origin = GPoint(x, y);
+  if (clip) {
+    grect_clip(rect, inside_rect);
+  }
+}
+
+static int32_t prv_trig_lookup(int32_t angle, double (*fn)(double)) {
+  return (int32_t)lround(fn(2 * M_PI * angle / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+int32_t sin_lookup(int32_t angle) {
+  return prv_trig_lookup(angle, sin);
+}
+
+int32_t cos_lookup(int32_t angle) {
+  return prv_trig_lookup(angle, cos);
+}
+
+int32_t atan2_lookup(int16_t y, int16_t x) {
+  int32_t angle = (int32_t)lround(atan2(y, x) * TRIG_MAX_ANGLE / (2 * M_PI));
+  return angle < 0 ? angle + TRIG_MAX_ANGLE : angle;
+}
+
+// In 1/8 pixel fixed point, like tools/dial_geometry.py computes the tables
+GPoint gpoint_from_polar(GRect rect, GOvalScaleMode scale_mode, int32_t angle) {
+  grect_standardize(&rect);
+  const int32_t center_x = rect.origin.x * 8 + (rect.size.w - 1) * 4;
+  const int32_t center_y = rect.origin.y * 8 + (rect.size.h - 1) * 4;
+  const int32_t side = scale_mode == GOvalScaleModeFitCircle ? MIN(rect.size.w, rect.size.h)
+                                                             : MAX(rect.size.w, rect.size.h);
+  const int32_t radius = (side - 1) * 4;
+  const int32_t x = center_x + sin_lookup(angle) * radius / TRIG_MAX_RATIO;
+  const int32_t y = center_y - cos_lookup(angle) * radius / TRIG_MAX_RATIO;
+  return GPoint(x >> 3, y >> 3);
+}
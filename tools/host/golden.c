@@ -0,0 +1,153 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "host.h"
+#include "enamel.h"
+
+// Reference frames of this platform, compared against the checked-in ones
+// by golden.py: launches the watchface at 10:10:34 on the 17th and writes
+// the frame buffer as a PPM image at fixed points,
+//
+//   intro-000 .. intro-075  the intro at 0, 25, 50 and 75% of its duration
+//   intro-100               once it is over
+//   full                    10:10:37.5, drawn from the dial cache, the
+//                           digit atlas and the hand rasterizer
+//   quick-view-slide        halfway through a Quick View sliding in, with
+//                           the dial cache scaled
+//   quick-view              once it is in
+//   tap-050                 halfway through the tap animation
+//   reduced, minimal        after the battery drops to each render quality
+//
+//   golden [--settings HEX] [--verbose] PREFIX
+//
+// writes PREFIX<frame>.ppm. --settings sends a message from
+// tools/host/settings_message.py as the window gets focus.
+
+#define LAUNCH_TIME 1710670234 // 2024-03-17 10:10:34 UTC
+#define FULL_MS 3500
+#define QUICK_VIEW_HEIGHT 51
+#define TAP_MS 1000
+#define SETTLE_MS 5000
+
+static const char *s_prefix;
+static uint8_t s_settings[256];
+static uint16_t s_settings_size;
+static uint64_t s_launch_ms;
+static bool s_failed;
+
+static void prv_run_to(uint32_t offset_ms) {
+  const uint64_t elapsed = host_now_ms() - s_launch_ms;
+  if (offset_ms > elapsed) {
+    host_run_for(offset_ms - elapsed);
+  }
+}
+
+// Binary PPM, 2-bit channels scaled to 8 bits, black and white on 1-bit
+// displays. The system draws the Quick View, the host leaves whatever was
+// there, so its area is written gray.
+static void prv_write_frame(const char *name) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s%s.ppm", s_prefix, name);
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    fprintf(stderr, "golden: cannot write %s\n", path);
+    s_failed = true;
+    return;
+  }
+  GBitmap *frame_buffer = host_frame_buffer();
+  const GSize size = gbitmap_get_bounds(frame_buffer).size;
+  fprintf(file, "P6\n%d %d\n255\n", size.w, size.h);
+  const int obstruction_y = size.h - host_obstruction();
+  for (int y = 0; y < size.h; y++) {
+    for (int x = 0; x < size.w; x++) {
+      const GColor color = y < obstruction_y ? host_frame_buffer_pixel(frame_buffer, x, y)
+                                             : GColorDarkGray;
+      const uint8_t rgb[3] = { color.r * 85, color.g * 85, color.b * 85 };
+      fwrite(rgb, 1, sizeof(rgb), file);
+    }
+  }
+  fclose(file);
+}
+
+static void prv_golden(void) {
+  s_launch_ms = host_now_ms();
+  // the app listens for settings, and starts the intro, once the window
+  // has focus
+  prv_run_to(HOST_PUSH_TRANSITION_MS);
+  if (s_settings_size) {
+    host_receive_message(s_settings, s_settings_size);
+  }
+  const uint32_t duration = enamel_get_intro_duration();
+  for (int percent = 0; percent < 100; percent += 25) {
+    char name[16];
+    snprintf(name, sizeof(name), "intro-%03d", percent);
+    prv_run_to(HOST_PUSH_TRANSITION_MS + duration * percent / 100);
+    prv_write_frame(name);
+  }
+  host_run_until_idle(SETTLE_MS);
+  prv_write_frame("intro-100");
+  prv_run_to(FULL_MS);
+  prv_write_frame("full");
+
+  host_set_obstruction(QUICK_VIEW_HEIGHT);
+  host_run_for(HOST_OBSTRUCTION_MS / 2);
+  prv_write_frame("quick-view-slide");
+  host_run_until_idle(SETTLE_MS);
+  prv_write_frame("quick-view");
+  host_set_obstruction(0);
+  host_run_until_idle(SETTLE_MS);
+
+  host_tap();
+  host_run_for(TAP_MS / 2);
+  prv_write_frame("tap-050");
+  host_run_until_idle(SETTLE_MS);
+
+  host_set_battery((BatteryChargeState) { .charge_percent = 15 });
+  host_run_until_idle(SETTLE_MS);
+  prv_write_frame("reduced");
+  host_set_battery((BatteryChargeState) { .charge_percent = 5 });
+  host_run_until_idle(SETTLE_MS);
+  prv_write_frame("minimal");
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--verbose") == 0) {
+      host_set_verbose(true);
+    }
+    else if (strcmp(argv[i], "--settings") == 0 && i + 1 < argc &&
+             host_parse_hex(argv[i + 1], s_settings, sizeof(s_settings), &s_settings_size)) {
+      i++;
+    }
+    else if (!s_prefix && argv[i][0] != '-') {
+      s_prefix = argv[i];
+    }
+    else {
+      s_prefix = NULL;
+      break;
+    }
+  }
+  if (!s_prefix) {
+    fprintf(stderr, "usage: %s [--settings HEX] [--verbose] PREFIX\n", argv[0]);
+    return 1;
+  }
+  host_init(LAUNCH_TIME, prv_golden);
+  host_launch();
+  return s_failed ? 1 : 0;
+}
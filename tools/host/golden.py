@@ -0,0 +1,248 @@
+"""Checks the frames and the draw cost of the watchface against a baseline.
+
+For every platform and clock font, with the date shown, runs
+build/host/<platform>/golden (see golden.c) and compares each frame pixel
+for pixel with tools/host/golden/<platform>/<font>-<frame>.png, then runs
+build/host/<platform>/bench (see bench.c) and compares its rows with
+tools/host/golden/baseline.csv: frames, redraws, primitives and frame
+buffer captures per frame must match, the time per frame may grow by the
+tolerance. Times are the best of a few runs.
+
+    python3 tools/host/golden.py check
+
+exits with 1 on any difference, with the frames that differ and a picture
+of the pixels that changed, in red, in build/host/golden/.
+
+    python3 tools/host/golden.py update
+
+rewrites the golden frames and the baseline, for changes that are meant to
+draw differently or cost something else.
+"""
+
+import csv
+import io
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import zlib
+from concurrent.futures import ThreadPoolExecutor
+
+from settings_message import ROOT, load_config, load_message_keys, message
+
+PLATFORMS = ('aplite', 'basalt', 'chalk', 'diorite', 'emery')
+FONTS = ('SQUARE', 'ROUNDED')
+GOLDEN = os.path.join(ROOT, 'tools', 'host', 'golden')
+BASELINE = os.path.join(GOLDEN, 'baseline.csv')
+# bench columns that identify a row, and those that must match exactly
+KEY = ('font', 'platform', 'quality', 'scenario', 'plane')
+EXACT = ('frames', 'redraws', 'primitives_per_frame', 'captures_per_frame')
+TIME = 'us_per_frame'
+
+
+def settings(font):
+    return message(load_config(), load_message_keys(), {'display_date': True, 'clock_font': font}).hex()
+
+
+def read_ppm(path):
+    with open(path, 'rb') as f:
+        magic, size, depth, pixels = f.read().split(b'\n', 3)
+    assert magic == b'P6' and depth == b'255'
+    width, height = size.split()
+    return int(width), int(height), pixels
+
+
+def png_chunk(kind, data):
+    return struct.pack('>I', len(data)) + kind + data + struct.pack('>I', zlib.crc32(kind + data))
+
+
+def write_png(path, width, height, pixels):
+    """8-bit RGB, no filtering"""
+    stride = width * 3
+    raw = b''.join(b'\0' + pixels[y * stride:(y + 1) * stride] for y in range(height))
+    with open(path, 'wb') as f:
+        f.write(b'\x89PNG\r\n\x1a\n' +
+                png_chunk(b'IHDR', struct.pack('>IIBBBBB', width, height, 8, 2, 0, 0, 0)) +
+                png_chunk(b'IDAT', zlib.compress(raw, 9)) + png_chunk(b'IEND', b''))
+
+
+def read_png(path):
+    """8-bit RGB PNG as written by write_png, any filter"""
+    with open(path, 'rb') as f:
+        data = f.read()
+    offset, idat = 8, b''
+    while offset < len(data):
+        size, kind = struct.unpack('>I4s', data[offset:offset + 8])
+        body = data[offset + 8:offset + 8 + size]
+        if kind == b'IHDR':
+            width, height, bits, color = struct.unpack('>IIBB', body[:10])
+            assert bits == 8 and color == 2, '%s: not 8-bit RGB' % path
+        elif kind == b'IDAT':
+            idat += body
+        offset += size + 12
+    raw, stride, pixels = zlib.decompress(idat), width * 3, bytearray()
+    previous = bytearray(stride)
+    for y in range(height):
+        kind, row = raw[y * (stride + 1)], bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for x in range(stride):
+            left = row[x - 3] if x >= 3 else 0
+            up, corner = previous[x], previous[x - 3] if x >= 3 else 0
+            if kind == 1:
+                row[x] = (row[x] + left) & 0xff
+            elif kind == 2:
+                row[x] = (row[x] + up) & 0xff
+            elif kind == 3:
+                row[x] = (row[x] + (left + up) // 2) & 0xff
+            elif kind == 4:
+                guess = left + up - corner
+                paeth = min((abs(guess - left), 0, left), (abs(guess - up), 1, up),
+                            (abs(guess - corner), 2, corner))[2]
+                row[x] = (row[x] + paeth) & 0xff
+        pixels += row
+        previous = row
+    return width, height, bytes(pixels)
+
+
+def frames(build, platform, font):
+    """{frame: (width, height, pixels)} rendered by the golden runner"""
+    folder = tempfile.mkdtemp()
+    try:
+        subprocess.run([os.path.join(build, platform, 'golden'), '--settings', settings(font),
+                        os.path.join(folder, '')], check=True)
+        return {name[:-4]: read_ppm(os.path.join(folder, name))
+                for name in sorted(os.listdir(folder))}
+    finally:
+        shutil.rmtree(folder)
+
+
+def diff_image(pixels, expected):
+    """The expected frame dimmed, with the pixels that differ in red"""
+    result = bytearray(expected[i] // 3 for i in range(len(expected)))
+    for i in range(0, len(pixels), 3):
+        if pixels[i:i + 3] != expected[i:i + 3]:
+            result[i:i + 3] = b'\xff\0\0'
+    return bytes(result)
+
+
+def check_frames(build, platform, font, output):
+    """(frames checked, failures)"""
+    failures = []
+    rendered = frames(build, platform, font)
+    for name, (width, height, pixels) in rendered.items():
+        path = os.path.join(GOLDEN, platform, '%s-%s.png' % (font, name))
+        label = '%s/%s-%s' % (platform, font, name)
+        if not os.path.exists(path):
+            failures.append('%s: no golden frame' % label)
+            continue
+        expected = read_png(path)
+        if expected[:2] != (width, height):
+            failures.append('%s: %dx%d instead of %dx%d' % ((label, width, height) + expected[:2]))
+            continue
+        changed = sum(pixels[i:i + 3] != expected[2][i:i + 3] for i in range(0, len(pixels), 3))
+        if changed:
+            folder = os.path.join(output, platform)
+            os.makedirs(folder, exist_ok=True)
+            write_png(os.path.join(folder, '%s-%s.png' % (font, name)), width, height, pixels)
+            write_png(os.path.join(folder, '%s-%s-diff.png' % (font, name)), width, height,
+                      diff_image(pixels, expected[2]))
+            failures.append('%s: %d pixels differ' % (label, changed))
+    return len(rendered), failures
+
+
+def update_frames(build, platform, font):
+    folder = os.path.join(GOLDEN, platform)
+    os.makedirs(folder, exist_ok=True)
+    rendered = frames(build, platform, font)
+    for name, (width, height, pixels) in rendered.items():
+        write_png(os.path.join(folder, '%s-%s.png' % (font, name)), width, height, pixels)
+    return len(rendered), []
+
+
+def bench(build, platform, font, runs):
+    """bench rows keyed by KEY, the time of each the best of the runs"""
+    rows = {}
+    for run in range(runs):
+        output = subprocess.run([os.path.join(build, platform, 'bench'), '--csv',
+                                 '--settings', settings(font)],
+                                check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+        for row in csv.DictReader(io.StringIO(output)):
+            row['font'] = font
+            key = tuple(row[column] for column in KEY)
+            if key not in rows or float(row[TIME]) < float(rows[key][TIME]):
+                rows[key] = row
+    return rows
+
+
+def check_bench(baseline, current, tolerance, slack):
+    failures = []
+    for key, row in current.items():
+        label = '/'.join(key)
+        expected = baseline.get(key)
+        if not expected:
+            failures.append('%s: not in the baseline' % label)
+            continue
+        for column in EXACT:
+            if row[column] != expected[column]:
+                failures.append('%s: %s %s instead of %s' % (label, column, row[column], expected[column]))
+        limit = float(expected[TIME]) * (1 + tolerance) + slack
+        if float(row[TIME]) > limit:
+            failures.append('%s: %s us per frame, baseline %s' % (label, row[TIME], expected[TIME]))
+    return failures
+
+
+def read_baseline():
+    with open(BASELINE, newline='') as f:
+        return {tuple(row[column] for column in KEY): row for row in csv.DictReader(f)}
+
+
+def write_baseline(rows, fields):
+    with open(BASELINE, 'w', newline='') as f:
+        writer = csv.DictWriter(f, fieldnames=fields, lineterminator='\n')
+        writer.writeheader()
+        writer.writerows(rows)
+
+
+if __name__ == '__main__':
+    import argparse
+    parser = argparse.ArgumentParser(description='Checks frames and draw cost against the golden ones')
+    parser.add_argument('command', choices=('check', 'update'))
+    parser.add_argument('--build', action='store', default=os.path.join(ROOT, 'build', 'host'),
+                        help='Folder of the host build')
+    parser.add_argument('--jobs', action='store', type=int, default=os.cpu_count(), help='Runs at once')
+    parser.add_argument('--runs', action='store', type=int, default=5,
+                        help='Bench runs, the best time of each row counts')
+    parser.add_argument('--tolerance', action='store', type=float, default=1.0,
+                        help='How much slower than the baseline a frame may get, 1.0 for twice as slow')
+    parser.add_argument('--slack', action='store', type=float, default=5.0,
+                        help='Microseconds per frame allowed on top of the tolerance')
+    args = parser.parse_args()
+    cells = [(platform, font) for platform in PLATFORMS for font in FONTS]
+    output = os.path.normpath(os.path.join(args.build, 'golden'))
+    if args.command == 'check':
+        shutil.rmtree(output, ignore_errors=True)
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        if args.command == 'check':
+            results = list(pool.map(lambda cell: check_frames(args.build, *cell, output=output), cells))
+        else:
+            results = list(pool.map(lambda cell: update_frames(args.build, *cell), cells))
+    count = sum(result[0] for result in results)
+    failures = sum((result[1] for result in results), [])
+    # one at a time, so that the times are not taken under load
+    current = {}
+    for platform, font in cells:
+        current.update(bench(args.build, platform, font, args.runs))
+    if args.command == 'check':
+        failures += check_bench(read_baseline(), current, args.tolerance, args.slack)
+    else:
+        fields = list(KEY) + [field for field in next(iter(current.values())) if field not in KEY]
+        write_baseline(list(current.values()), fields)
+    for failure in failures:
+        sys.stderr.write(failure + '\n')
+    if failures:
+        sys.stderr.write('%d differences' % len(failures) +
+                         (', frames that differ are in %s\n' % output if os.path.isdir(output) else '\n'))
+        sys.exit(1)
+    sys.stderr.write('%s %d frames and %d bench rows\n'
+                     % ('checked' if args.command == 'check' else 'updated', count, len(current)))
@@ -0,0 +1,804 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "host_sdk.h"
+#include <math.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+// Software rasterizer over the frame buffer of the platform: 1-bit on
+// aplite and diorite, GColor8 bytes elsewhere, with only part of each row
+// on the round display of chalk. Layer coordinates are moved by the offset
+// of the context and clipped to its clip box, which the layer tree sets up
+// for each update proc. The shapes follow the firmware closely enough to
+// see what a change to the draw code does, not to the pixel: in particular
+// antialiasing is not emulated, and text uses the fonts rendered with
+// FreeType the way the SDK converts them.
+
+static GBitmap *s_frame_buffer;
+static GContext s_context;
+// visible part of each row of the display
+static int16_t s_row_min_x[PBL_DISPLAY_HEIGHT];
+static int16_t s_row_max_x[PBL_DISPLAY_HEIGHT];
+
+// ---------------------------------------------------------------------------
+// Bitmaps
+
+static uint16_t prv_bytes_per_row(int16_t width, GBitmapFormat format) {
+  // 1-bit rows are padded to whole words like the firmware's
+  return format == GBitmapFormat1Bit ? ((width + 31) / 32) * 4 : width;
+}
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format) {
+  if (format != GBitmapFormat1Bit && format != GBitmapFormat8Bit &&
+      format != GBitmapFormat8BitCircular) {
+    return NULL;
+  }
+  GBitmap *bitmap = calloc(1, sizeof(GBitmap));
+  if (!bitmap) {
+    return NULL;
+  }
+  bitmap->format = format;
+  bitmap->bounds = (GRect) { .size = size };
+  bitmap->bytes_per_row = prv_bytes_per_row(size.w, format);
+  bitmap->data = calloc(size.h ? size.h : 1, bitmap->bytes_per_row ? bitmap->bytes_per_row : 1);
+  if (!bitmap->data) {
+    free(bitmap);
+    return NULL;
+  }
+  return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+  if (bitmap) {
+    free(bitmap->data);
+    free(bitmap);
+  }
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap) {
+  return bitmap->bounds;
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap) {
+  return bitmap->format;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap) {
+  return bitmap->bytes_per_row;
+}
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap) {
+  return bitmap->data;
+}
+
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap, uint16_t y) {
+  GBitmapDataRowInfo info = {
+    .data = &bitmap->data[y * bitmap->bytes_per_row],
+    .min_x = bitmap->bounds.origin.x,
+    .max_x = bitmap->bounds.origin.x + bitmap->bounds.size.w - 1,
+  };
+  if (bitmap->format == GBitmapFormat8BitCircular && y < PBL_DISPLAY_HEIGHT) {
+    info.min_x = s_row_min_x[y];
+    info.max_x = s_row_max_x[y];
+  }
+  return info;
+}
+
+static bool prv_get_bit(const uint8_t *row, int x) {
+  return row[x / 8] & (1 << (x % 8));
+}
+
+static void prv_set_bit(uint8_t *row, int x, bool white) {
+  if (white) {
+    row[x / 8] |= 1 << (x % 8);
+  }
+  else {
+    row[x / 8] &= ~(1 << (x % 8));
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Colors
+
+bool gcolor_equal(GColor8 x, GColor8 y) {
+  return x.argb == y.argb || (x.a == 0 && y.a == 0);
+}
+
+GColor8 gcolor_legible_over(GColor8 background_color) {
+  return background_color.r + background_color.g + background_color.b >= 5 ? GColorBlack
+                                                                              : GColorWhite;
+}
+
+// 1-bit displays show light colors white, dark ones black and dither the
+// ones in between
+static bool prv_bw_white(GColor color, int x, int y) {
+  const int luma = color.r + color.g + color.b;
+  if (luma >= 7) {
+    return true;
+  }
+  if (luma <= 2) {
+    return false;
+  }
+  return (x + y) % 2 == 0;
+}
+
+// ---------------------------------------------------------------------------
+// Frame buffer
+
+void host_graphics_init(void) {
+#if defined(PBL_ROUND)
+  const GBitmapFormat format = GBitmapFormat8BitCircular;
+  for (int y = 0; y < PBL_DISPLAY_HEIGHT; y++) {
+    const double radius = PBL_DISPLAY_WIDTH / 2.0;
+    const double dy = y + 0.5 - PBL_DISPLAY_HEIGHT / 2.0;
+    const int half = (int)lround(sqrt(radius * radius - dy * dy));
+    s_row_min_x[y] = PBL_DISPLAY_WIDTH / 2 - half;
+    s_row_max_x[y] = PBL_DISPLAY_WIDTH / 2 + half - 1;
+  }
+#else
+  const GBitmapFormat format = PBL_IF_COLOR_ELSE(GBitmapFormat8Bit, GBitmapFormat1Bit);
+  for (int y = 0; y < PBL_DISPLAY_HEIGHT; y++) {
+    s_row_min_x[y] = 0;
+    s_row_max_x[y] = PBL_DISPLAY_WIDTH - 1;
+  }
+#endif
+  gbitmap_destroy(s_frame_buffer);
+  s_frame_buffer = gbitmap_create_blank(GSize(PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT), format);
+  if (format != GBitmapFormat1Bit) {
+    memset(s_frame_buffer->data, GColorBlackARGB8,
+           PBL_DISPLAY_HEIGHT * s_frame_buffer->bytes_per_row);
+  }
+}
+
+void host_graphics_deinit(void) {
+  gbitmap_destroy(s_frame_buffer);
+  s_frame_buffer = NULL;
+}
+
+bool host_frame_buffer_row_range(int y, int *min_x, int *max_x) {
+  if (y < 0 || y >= PBL_DISPLAY_HEIGHT) {
+    return false;
+  }
+  *min_x = s_row_min_x[y];
+  *max_x = s_row_max_x[y];
+  return true;
+}
+
+GBitmap *host_frame_buffer(void) {
+  return s_frame_buffer;
+}
+
+GBitmap *host_frame_buffer_copy(void) {
+  GBitmap *copy = gbitmap_create_blank(s_frame_buffer->bounds.size, s_frame_buffer->format);
+  memcpy(copy->data, s_frame_buffer->data, PBL_DISPLAY_HEIGHT * s_frame_buffer->bytes_per_row);
+  return copy;
+}
+
+GColor host_frame_buffer_pixel(const GBitmap *frame_buffer, int x, int y) {
+  const uint8_t *row = &frame_buffer->data[y * frame_buffer->bytes_per_row];
+  if (frame_buffer->format == GBitmapFormat1Bit) {
+    return prv_get_bit(row, x) ? GColorWhite : GColorBlack;
+  }
+  return (GColor8) { .argb = row[x] };
+}
+
+uint32_t host_frame_buffer_diff(const GBitmap *a, const GBitmap *b) {
+  uint32_t count = 0;
+  for (int y = 0; y < PBL_DISPLAY_HEIGHT; y++) {
+    const uint8_t *row_a = &a->data[y * a->bytes_per_row];
+    const uint8_t *row_b = &b->data[y * b->bytes_per_row];
+    if (memcmp(row_a, row_b, a->bytes_per_row) == 0) {
+      continue;
+    }
+    for (int x = s_row_min_x[y]; x <= s_row_max_x[y]; x++) {
+      if (a->format == GBitmapFormat1Bit ? prv_get_bit(row_a, x) != prv_get_bit(row_b, x)
+                                         : row_a[x] != row_b[x]) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+// ---------------------------------------------------------------------------
+// Context
+
+GContext *host_graphics_context(GPoint offset, GRect clip) {
+  GRect screen = GRect(0, 0, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT);
+  grect_clip(&clip, &screen);
+  s_context = (GContext) {
+    .frame_buffer = s_frame_buffer,
+    .offset = offset,
+    .clip = clip,
+    .stroke_color = GColorBlack,
+    .fill_color = GColorBlack,
+    .text_color = GColorWhite,
+    .stroke_width = 1,
+    .antialiased = PBL_IF_COLOR_ELSE(true, false),
+    .compositing_mode = GCompOpAssign,
+  };
+  return &s_context;
+}
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {
+  ctx->stroke_color = color;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+  ctx->fill_color = color;
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color) {
+  ctx->text_color = color;
+}
+
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode) {
+  ctx->compositing_mode = mode;
+}
+
+void graphics_context_set_antialiased(GContext *ctx, bool enable) {
+  ctx->antialiased = enable;
+}
+
+void graphics_context_set_stroke_width(GContext *ctx, uint8_t stroke_width) {
+  // the firmware only draws odd widths
+  ctx->stroke_width = stroke_width ? stroke_width | 1 : 1;
+}
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx) {
+  if (ctx->captured) {
+    return NULL;
+  }
+  ctx->captured = true;
+  host_stats_frame_buffer_captured();
+  return ctx->frame_buffer;
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer) {
+  if (!ctx->captured || buffer != ctx->frame_buffer) {
+    return false;
+  }
+  ctx->captured = false;
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Spans, in screen coordinates
+
+// Paints x0..x1 of row y, clipped to the context and the display
+static void prv_span(GContext *ctx, int y, int x0, int x1, GColor color) {
+  if (color.a == 0 || ctx->captured) {
+    return;
+  }
+  const GRect clip = ctx->clip;
+  if (y < clip.origin.y || y >= clip.origin.y + clip.size.h) {
+    return;
+  }
+  x0 = MAX(x0, MAX(clip.origin.x, s_row_min_x[y]));
+  x1 = MIN(x1, MIN(clip.origin.x + clip.size.w - 1, s_row_max_x[y]));
+  if (x0 > x1) {
+    return;
+  }
+  uint8_t *row = &ctx->frame_buffer->data[y * ctx->frame_buffer->bytes_per_row];
+  if (ctx->frame_buffer->format == GBitmapFormat1Bit) {
+    for (int x = x0; x <= x1; x++) {
+      prv_set_bit(row, x, prv_bw_white(color, x, y));
+    }
+  }
+  else {
+    color.a = 3;
+    memset(&row[x0], color.argb, x1 - x0 + 1);
+  }
+}
+
+static void prv_pixel(GContext *ctx, int x, int y, GColor color) {
+  prv_span(ctx, y, x, x, color);
+}
+
+static int prv_isqrt(int64_t value) {
+  if (value <= 0) {
+    return 0;
+  }
+  int64_t root = (int64_t)sqrt((double)value);
+  while (root * root > value) {
+    root--;
+  }
+  while ((root + 1) * (root + 1) <= value) {
+    root++;
+  }
+  return (int)root;
+}
+
+// Filled disc of pixel centers at most radius / 2 away from the center,
+// all in 1/2 pixel units, the center on a pixel center or between two
+static void prv_disc(GContext *ctx, int center_x2, int center_y2, int diameter, GColor color) {
+  const int reach = diameter / 2 + 1;
+  const int cy = center_y2 / 2;
+  for (int y = cy - reach; y <= cy + reach; y++) {
+    const int64_t dy2 = 2 * y - center_y2;
+    const int64_t rest = (int64_t)diameter * diameter - dy2 * dy2;
+    if (rest < 0) {
+      continue;
+    }
+    const int half2 = prv_isqrt(rest);
+    // pixel x is inside when |2x - center_x2| <= half2
+    const int x0 = (int)ceil((center_x2 - half2) / 2.0);
+    const int x1 = (int)floor((center_x2 + half2) / 2.0);
+    prv_span(ctx, y, x0, x1, color);
+  }
+}
+
+// Pixels whose center is at most width / 2 away from the segment, the same
+// round capped stroke hand_raster.c writes
+static void prv_capsule(GContext *ctx, GPoint from, GPoint to, int width, GColor color) {
+  const int reach = width / 2 + 1;
+  const int dx = to.x - from.x;
+  const int dy = to.y - from.y;
+  const int64_t len2 = (int64_t)dx * dx + (int64_t)dy * dy;
+  const int y0 = MIN(from.y, to.y) - reach;
+  const int y1 = MAX(from.y, to.y) + reach;
+  const int x0 = MIN(from.x, to.x) - reach;
+  const int x1 = MAX(from.x, to.x) + reach;
+  const int64_t width2 = (int64_t)width * width;
+  for (int y = y0; y <= y1; y++) {
+    int min_x = INT16_MAX;
+    int max_x = INT16_MIN;
+    for (int x = x0; x <= x1; x++) {
+      const int64_t a = x - from.x;
+      const int64_t b = y - from.y;
+      int64_t dist2_4;
+      const int64_t t = a * dx + b * dy;
+      if (len2 == 0 || t <= 0) {
+        dist2_4 = 4 * (a * a + b * b);
+      }
+      else if (t >= len2) {
+        const int64_t ea = x - to.x;
+        const int64_t eb = y - to.y;
+        dist2_4 = 4 * (ea * ea + eb * eb);
+      }
+      else {
+        const int64_t cross = a * dy - b * dx;
+        // 4 * cross^2 / len2 <= width^2, kept in integers
+        dist2_4 = (4 * cross * cross + len2 - 1) / len2;
+      }
+      if (dist2_4 <= width2) {
+        min_x = MIN(min_x, x);
+        max_x = MAX(max_x, x);
+      }
+    }
+    if (min_x <= max_x) {
+      prv_span(ctx, y, min_x, max_x, color);
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Primitives
+
+void graphics_draw_pixel(GContext *ctx, GPoint point) {
+  prv_pixel(ctx, point.x + ctx->offset.x, point.y + ctx->offset.y, ctx->stroke_color);
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1) {
+  p0 = GPoint(p0.x + ctx->offset.x, p0.y + ctx->offset.y);
+  p1 = GPoint(p1.x + ctx->offset.x, p1.y + ctx->offset.y);
+  if (ctx->stroke_width > 1) {
+    prv_capsule(ctx, p0, p1, ctx->stroke_width, ctx->stroke_color);
+    return;
+  }
+  // Bresenham, both ends included
+  int x = p0.x;
+  int y = p0.y;
+  const int dx = abs(p1.x - p0.x);
+  const int dy = -abs(p1.y - p0.y);
+  const int sx = p0.x < p1.x ? 1 : -1;
+  const int sy = p0.y < p1.y ? 1 : -1;
+  int error = dx + dy;
+  while (true) {
+    prv_pixel(ctx, x, y, ctx->stroke_color);
+    if (x == p1.x && y == p1.y) {
+      break;
+    }
+    const int error2 = 2 * error;
+    if (error2 >= dy) {
+      error += dy;
+      x += sx;
+    }
+    if (error2 <= dx) {
+      error += dx;
+      y += sy;
+    }
+  }
+}
+
+void graphics_draw_rect(GContext *ctx, GRect rect) {
+  grect_standardize(&rect);
+  if (grect_is_empty(&rect)) {
+    return;
+  }
+  const int x0 = rect.origin.x;
+  const int y0 = rect.origin.y;
+  const int x1 = x0 + rect.size.w - 1;
+  const int y1 = y0 + rect.size.h - 1;
+  const uint8_t width = ctx->stroke_width;
+  ctx->stroke_width = 1;
+  graphics_draw_line(ctx, GPoint(x0, y0), GPoint(x1, y0));
+  graphics_draw_line(ctx, GPoint(x0, y1), GPoint(x1, y1));
+  graphics_draw_line(ctx, GPoint(x0, y0), GPoint(x0, y1));
+  graphics_draw_line(ctx, GPoint(x1, y0), GPoint(x1, y1));
+  ctx->stroke_width = width;
+}
+
+// Columns left out at row i of a rounded corner of the given radius
+static int prv_corner_inset(int radius, int i) {
+  const int dy = radius - i;
+  return radius - (int)lround(sqrt((double)radius * radius - (double)dy * dy));
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius,
+                        GCornerMask corner_mask) {
+  grect_standardize(&rect);
+  const int radius = MIN(corner_radius, MIN(rect.size.w, rect.size.h) / 2);
+  const int x0 = rect.origin.x + ctx->offset.x;
+  const int y0 = rect.origin.y + ctx->offset.y;
+  for (int i = 0; i < rect.size.h; i++) {
+    int left = 0;
+    int right = 0;
+    if (i < radius) {
+      left = corner_mask & GCornerTopLeft ? prv_corner_inset(radius, i) : 0;
+      right = corner_mask & GCornerTopRight ? prv_corner_inset(radius, i) : 0;
+    }
+    else if (i >= rect.size.h - radius) {
+      const int j = rect.size.h - 1 - i;
+      left = corner_mask & GCornerBottomLeft ? prv_corner_inset(radius, j) : 0;
+      right = corner_mask & GCornerBottomRight ? prv_corner_inset(radius, j) : 0;
+    }
+    prv_span(ctx, y0 + i, x0 + left, x0 + rect.size.w - 1 - right, ctx->fill_color);
+  }
+}
+
+void graphics_draw_circle(GContext *ctx, GPoint p, uint16_t radius) {
+  const int cx = p.x + ctx->offset.x;
+  const int cy = p.y + ctx->offset.y;
+  const GColor color = ctx->stroke_color;
+  if (ctx->stroke_width > 1) {
+    // ring of pixel centers within half the width of the circle
+    const int half = ctx->stroke_width / 2;
+    const int outer = radius + half;
+    const int inner = MAX((int)radius - half, 0);
+    for (int dy = -outer; dy <= outer; dy++) {
+      const int out = prv_isqrt((int64_t)outer * outer - (int64_t)dy * dy);
+      const int64_t in2 = (int64_t)inner * inner - (int64_t)dy * dy;
+      if (abs(dy) > inner || in2 <= 0) {
+        prv_span(ctx, cy + dy, cx - out, cx + out, color);
+        continue;
+      }
+      const int in = prv_isqrt(in2 - 1);
+      prv_span(ctx, cy + dy, cx - out, cx - in - 1, color);
+      prv_span(ctx, cy + dy, cx + in + 1, cx + out, color);
+    }
+    return;
+  }
+  // midpoint circle
+  int x = radius;
+  int y = 0;
+  int error = 1 - x;
+  while (x >= y) {
+    const GPoint points[] = {
+      GPoint(x, y), GPoint(y, x), GPoint(-y, x), GPoint(-x, y),
+      GPoint(-x, -y), GPoint(-y, -x), GPoint(y, -x), GPoint(x, -y),
+    };
+    for (unsigned i = 0; i < ARRAY_LENGTH(points); i++) {
+      prv_pixel(ctx, cx + points[i].x, cy + points[i].y, color);
+    }
+    y++;
+    if (error < 0) {
+      error += 2 * y + 1;
+    }
+    else {
+      x--;
+      error += 2 * (y - x) + 1;
+    }
+  }
+}
+
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius) {
+  prv_disc(ctx, 2 * (p.x + ctx->offset.x), 2 * (p.y + ctx->offset.y), 2 * radius,
+           ctx->fill_color);
+}
+
+static bool prv_angle_between(int32_t angle, int32_t from, int32_t to) {
+  if (to - from >= TRIG_MAX_ANGLE) {
+    return true;
+  }
+  int32_t offset = (angle - from) % TRIG_MAX_ANGLE;
+  if (offset < 0) {
+    offset += TRIG_MAX_ANGLE;
+  }
+  int32_t span = (to - from) % TRIG_MAX_ANGLE;
+  if (span < 0) {
+    span += TRIG_MAX_ANGLE;
+  }
+  return offset <= span;
+}
+
+// Ring between the circle fitted in rect and the one inset_thickness
+// inside it, with the center and radius gpoint_from_polar uses
+void graphics_fill_radial(GContext *ctx, GRect rect, GOvalScaleMode scale_mode,
+                          uint16_t inset_thickness, int32_t angle_start, int32_t angle_end) {
+  grect_standardize(&rect);
+  rect.origin.x += ctx->offset.x;
+  rect.origin.y += ctx->offset.y;
+  const int side = scale_mode == GOvalScaleModeFitCircle ? MIN(rect.size.w, rect.size.h)
+                                                         : MAX(rect.size.w, rect.size.h);
+  if (side <= 0) {
+    return;
+  }
+  // all in 1/8 pixel, pixel x has its center at 8 * x
+  const int64_t center_x = rect.origin.x * 8 + (rect.size.w - 1) * 4;
+  const int64_t center_y = rect.origin.y * 8 + (rect.size.h - 1) * 4;
+  const int64_t outer = (side - 1) * 4 + 4;
+  const int64_t inner = outer - inset_thickness * 8;
+  const bool full = angle_end - angle_start >= TRIG_MAX_ANGLE;
+  for (int y = (center_y - outer) / 8 - 1; y <= (center_y + outer) / 8 + 1; y++) {
+    const int64_t dy = y * 8 - center_y;
+    const int64_t out2 = outer * outer - dy * dy;
+    if (out2 < 0) {
+      continue;
+    }
+    const int out = prv_isqrt(out2);
+    const int x0 = (int)ceil((center_x - out) / 8.0);
+    const int x1 = (int)floor((center_x + out) / 8.0);
+    const int64_t in2 = inner > 0 ? inner * inner - dy * dy : -1;
+    if (full) {
+      if (in2 <= 0) {
+        prv_span(ctx, y, x0, x1, ctx->fill_color);
+      }
+      else {
+        // pixels strictly inside the inner circle are left out
+        const int in = prv_isqrt(in2 - 1);
+        prv_span(ctx, y, x0, (int)ceil((center_x - in) / 8.0) - 1, ctx->fill_color);
+        prv_span(ctx, y, (int)floor((center_x + in) / 8.0) + 1, x1, ctx->fill_color);
+      }
+      continue;
+    }
+    for (int x = x0; x <= x1; x++) {
+      const int64_t dx = x * 8 - center_x;
+      if (dx * dx + dy * dy < in2 + dy * dy && in2 > 0) {
+        continue;
+      }
+      const int32_t angle = atan2_lookup(dx, -dy);
+      if (prv_angle_between(angle, angle_start, angle_end)) {
+        prv_pixel(ctx, x, y, ctx->fill_color);
+      }
+    }
+  }
+}
+
+// Tiles the bitmap over rect. Same format rows are copied as they are,
+// other pixels are converted.
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect) {
+  if (!bitmap || ctx->captured) {
+    return;
+  }
+  grect_standardize(&rect);
+  rect.origin.x += ctx->offset.x;
+  rect.origin.y += ctx->offset.y;
+  GRect area = rect;
+  grect_clip(&area, &ctx->clip);
+  const GRect source = bitmap->bounds;
+  if (grect_is_empty(&area) || grect_is_empty(&source)) {
+    return;
+  }
+  GBitmap *target = ctx->frame_buffer;
+  const bool from_1bit = bitmap->format == GBitmapFormat1Bit;
+  const bool to_1bit = target->format == GBitmapFormat1Bit;
+  const bool set = ctx->compositing_mode == GCompOpSet;
+  for (int y = area.origin.y; y < area.origin.y + area.size.h; y++) {
+    const int source_y = source.origin.y + (y - rect.origin.y) % source.size.h;
+    const uint8_t *from = &bitmap->data[source_y * bitmap->bytes_per_row];
+    uint8_t *to = &target->data[y * target->bytes_per_row];
+    const int x0 = MAX(area.origin.x, s_row_min_x[y]);
+    const int x1 = MIN(area.origin.x + area.size.w - 1, s_row_max_x[y]);
+    if (x0 > x1) {
+      continue;
+    }
+    const int source_x0 = source.origin.x + (x0 - rect.origin.x) % source.size.w;
+    if (!set && from_1bit == to_1bit && !to_1bit &&
+        source_x0 + (x1 - x0) < source.origin.x + source.size.w) {
+      memcpy(&to[x0], &from[source_x0], x1 - x0 + 1);
+      continue;
+    }
+    for (int x = x0; x <= x1; x++) {
+      const int source_x = source.origin.x + (x - rect.origin.x) % source.size.w;
+      GColor color;
+      if (from_1bit) {
+        const bool white = prv_get_bit(from, source_x);
+        if (set && !white) {
+          continue;
+        }
+        color = white ? GColorWhite : GColorBlack;
+      }
+      else {
+        color = (GColor8) { .argb = from[source_x] };
+        if (set && color.a == 0) {
+          continue;
+        }
+      }
+      if (to_1bit) {
+        prv_set_bit(to, x, from_1bit ? gcolor_equal(color, GColorWhite)
+                                     : prv_bw_white(color, x, y));
+      }
+      else {
+        color.a = 3;
+        to[x] = color.argb;
+      }
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Fonts
+
+#define FONT_FIRST_CHAR 32
+#define FONT_LAST_CHAR 126
+
+typedef struct {
+  GBitmap *bitmap;
+  int16_t left;
+  int16_t top;
+  int16_t advance;
+} Glyph;
+
+// Glyphs are rendered once at load, in monochrome like the SDK converts
+// TrueType fonts for the watch
+struct FontInfo {
+  int16_t line_height;
+  int16_t ascender;
+  Glyph glyphs[FONT_LAST_CHAR - FONT_FIRST_CHAR + 1];
+};
+
+static FT_Library s_freetype;
+
+ResHandle resource_get_handle(uint32_t resource_id) {
+  if (resource_id == 0 || (int)resource_id > host_resource_count) {
+    return NULL;
+  }
+  return &host_resources[resource_id - 1];
+}
+
+GFont fonts_load_custom_font(ResHandle handle) {
+  if (!handle || (!s_freetype && FT_Init_FreeType(&s_freetype))) {
+    return NULL;
+  }
+  FT_Face face;
+  if (FT_New_Face(s_freetype, handle->path, 0, &face)) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Cannot load font %s", handle->path);
+    return NULL;
+  }
+  FT_Set_Pixel_Sizes(face, 0, handle->font_size);
+  struct FontInfo *font = calloc(1, sizeof(struct FontInfo));
+  font->ascender = face->size->metrics.ascender >> 6;
+  font->line_height = (face->size->metrics.ascender - face->size->metrics.descender) >> 6;
+  for (int c = FONT_FIRST_CHAR; c <= FONT_LAST_CHAR; c++) {
+    Glyph *glyph = &font->glyphs[c - FONT_FIRST_CHAR];
+    if (FT_Load_Char(face, c, FT_LOAD_RENDER | FT_LOAD_MONOCHROME | FT_LOAD_TARGET_MONO)) {
+      continue;
+    }
+    const FT_GlyphSlot slot = face->glyph;
+    glyph->left = slot->bitmap_left;
+    glyph->top = slot->bitmap_top;
+    glyph->advance = slot->advance.x >> 6;
+    if (!slot->bitmap.width || !slot->bitmap.rows) {
+      continue;
+    }
+    // coverage as a 1-bit bitmap, set pixels are the ink
+    glyph->bitmap = gbitmap_create_blank(GSize(slot->bitmap.width, slot->bitmap.rows),
+                                         GBitmapFormat1Bit);
+    for (unsigned y = 0; y < slot->bitmap.rows; y++) {
+      const uint8_t *row = &slot->bitmap.buffer[y * slot->bitmap.pitch];
+      for (unsigned x = 0; x < slot->bitmap.width; x++) {
+        if (row[x / 8] & (0x80 >> (x % 8))) {
+          prv_set_bit(&glyph->bitmap->data[y * glyph->bitmap->bytes_per_row], x, true);
+        }
+      }
+    }
+  }
+  FT_Done_Face(face);
+  return font;
+}
+
+void fonts_unload_custom_font(GFont font) {
+  if (!font) {
+    return;
+  }
+  for (unsigned i = 0; i < ARRAY_LENGTH(font->glyphs); i++) {
+    gbitmap_destroy(font->glyphs[i].bitmap);
+  }
+  free(font);
+}
+
+static const Glyph *prv_glyph(GFont font, char c) {
+  if (c < FONT_FIRST_CHAR || c > FONT_LAST_CHAR) {
+    return NULL;
+  }
+  return &font->glyphs[c - FONT_FIRST_CHAR];
+}
+
+// Single line text, the only kind the watchface draws
+GSize graphics_text_layout_get_content_size(const char *text, GFont const font,
+                                            const GRect box,
+                                            const GTextOverflowMode overflow_mode,
+                                            const GTextAlignment alignment) {
+  if (!font || !text || !*text) {
+    return GSizeZero;
+  }
+  int width = 0;
+  for (const char *c = text; *c; c++) {
+    const Glyph *glyph = prv_glyph(font, *c);
+    width += glyph ? glyph->advance : 0;
+  }
+  return GSize(MIN(width, box.size.w), MIN(font->line_height, box.size.h));
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, GFont const font, const GRect box,
+                        const GTextOverflowMode overflow_mode, const GTextAlignment alignment,
+                        GTextAttributes *text_attributes) {
+  if (!font || !text || ctx->captured) {
+    return;
+  }
+  const GSize size = graphics_text_layout_get_content_size(text, font, box, overflow_mode,
+                                                           alignment);
+  int x = box.origin.x;
+  if (alignment == GTextAlignmentCenter) {
+    x += (box.size.w - size.w) / 2;
+  }
+  else if (alignment == GTextAlignmentRight) {
+    x += box.size.w - size.w;
+  }
+  // glyphs never leave the box
+  GRect clip = GRect(box.origin.x + ctx->offset.x, box.origin.y + ctx->offset.y, box.size.w,
+                     box.size.h);
+  const GRect saved_clip = ctx->clip;
+  grect_clip(&clip, &ctx->clip);
+  ctx->clip = clip;
+  const int baseline = box.origin.y + ctx->offset.y + font->ascender;
+  for (const char *c = text; *c; c++) {
+    const Glyph *glyph = prv_glyph(font, *c);
+    if (!glyph) {
+      continue;
+    }
+    if (glyph->bitmap) {
+      const int left = x + ctx->offset.x + glyph->left;
+      const int top = baseline - glyph->top;
+      const GSize glyph_size = glyph->bitmap->bounds.size;
+      for (int y = 0; y < glyph_size.h; y++) {
+        const uint8_t *row = &glyph->bitmap->data[y * glyph->bitmap->bytes_per_row];
+        for (int gx = 0; gx < glyph_size.w; gx++) {
+          if (prv_get_bit(row, gx)) {
+            prv_pixel(ctx, left + gx, top + y, ctx->text_color);
+          }
+        }
+      }
+    }
+    x += glyph->advance;
+  }
+  ctx->clip = saved_clip;
+}
@@ -0,0 +1,110 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <pebble.h>
+
+// Host build of the watchface: src/ and the generated enamel.c compiled
+// for Linux against include/pebble.h, with the SDK implemented in software
+// by the files of this folder.
+//
+// Time is simulated. The app runs through its real main(), renamed
+// vuela_main(), and app_event_loop() hands control to the scenario of the
+// runner, which moves the clock forward with host_run_for(); timers, ticks
+// and animation frames fire in order on the way, and the window is drawn
+// into the frame buffer after every event that marked a layer dirty, the
+// way the firmware draws after each event of its loop.
+
+int vuela_main(void);
+
+typedef void (*HostScenario)(void);
+
+// Sets the launch time and what app_event_loop() does, see host_launch()
+void host_init(time_t launch_time, HostScenario scenario);
+// Runs vuela_main() with the scenario, resets the SDK state afterwards
+void host_launch(void);
+void host_set_verbose(bool verbose);
+
+// Window push transition, after which the app gets focus
+#define HOST_PUSH_TRANSITION_MS 300
+// Timeline Quick View slide
+#define HOST_OBSTRUCTION_MS 250
+
+// Simulated clock, in ms since the epoch
+uint64_t host_now_ms(void);
+// Dispatches every event due in the next ms, then sets the clock there
+void host_run_for(uint32_t ms);
+// Runs until no timer, animation or transition is pending, or at most ms
+void host_run_until_idle(uint32_t max_ms);
+
+// Input, delivered at the current time like the system would
+void host_tap(void);
+void host_set_battery(BatteryChargeState state);
+// Slides a Timeline Quick View of the given height in, 0 slides it out
+void host_set_obstruction(int16_t height);
+// Height covered by the Quick View now, part of it while it slides
+int16_t host_obstruction(void);
+// Delivers a serialized dictionary to the inbox, e.g. the settings from
+// tools/host/settings_message.py
+void host_receive_message(const uint8_t *dictionary, uint16_t size);
+void host_persist_clear(void);
+// Calls into the app as an event of its own, e.g. a handler of the model
+void host_call(void (*callback)(void *data), void *data);
+
+// Frame buffer of the platform, drawn into by the app
+GBitmap *host_frame_buffer(void);
+// Compares frame buffer rows, pixels outside the display on round screens
+// excluded
+uint32_t host_frame_buffer_diff(const GBitmap *a, const GBitmap *b);
+GBitmap *host_frame_buffer_copy(void);
+// Pixel at x, y as a GColor8, black and white on 1-bit displays
+GColor host_frame_buffer_pixel(const GBitmap *frame_buffer, int x, int y);
+
+// What the SDK saw since the last host_counters_reset()
+typedef struct {
+  // event loop turns that found something to do, one per point in time
+  uint32_t wakeups;
+  uint32_t events;
+  uint32_t ticks;
+  uint32_t timers;
+  uint32_t animation_frames;
+  uint32_t taps;
+  uint32_t messages_in;
+  uint32_t messages_out;
+  uint32_t frames;
+  // area of the layers drawn, clipped to what each frame repainted
+  uint64_t pixels_drawn;
+  // pixels that ended up with another value after a frame
+  uint64_t pixels_changed;
+} HostCounters;
+
+const HostCounters *host_counters(void);
+void host_counters_reset(void);
+// Counting changed pixels copies the frame buffer on every frame
+void host_count_changed_pixels(bool enable);
+
+// Platform name, e.g. "basalt"
+const char *host_platform(void);
+
+// Reads a payload given in hex on the command line of a runner
+bool host_parse_hex(const char *hex, uint8_t *data, size_t capacity, uint16_t *size);
+
+#endif
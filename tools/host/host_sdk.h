@@ -0,0 +1,95 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HOST_SDK_H
+#define HOST_SDK_H
+
+#include "host.h"
+
+// Shared by the files implementing the SDK, not part of the app's view of
+// it.
+
+// Animation frames are spaced like the firmware's default 30 fps
+#define HOST_ANIMATION_FRAME_MS 33
+
+struct GBitmap {
+  uint8_t *data;
+  uint16_t bytes_per_row;
+  GBitmapFormat format;
+  GRect bounds;
+};
+
+struct GContext {
+  GBitmap *frame_buffer;
+  bool captured;
+  // layer coordinates are moved by offset, drawing is limited to clip
+  GPoint offset;
+  GRect clip;
+  GColor stroke_color;
+  GColor fill_color;
+  GColor text_color;
+  uint8_t stroke_width;
+  bool antialiased;
+  GCompOp compositing_mode;
+};
+
+// Resources listed in package.json, generated into resources.auto.c
+struct HostResource {
+  const char *path;
+  int font_size;
+};
+
+extern const struct HostResource host_resources[];
+extern const int host_resource_count;
+
+// graphics.c
+void host_graphics_init(void);
+void host_graphics_deinit(void);
+GContext *host_graphics_context(GPoint offset, GRect clip);
+bool host_frame_buffer_row_range(int y, int *min_x, int *max_x);
+
+// layers.c
+void host_layers_reset(void);
+// Draws the window on top of the stack if a layer was marked dirty
+void host_render_if_dirty(void);
+void host_set_obstruction_now(int16_t height);
+
+// events.c
+void host_events_reset(void);
+HostCounters *host_counters_mutable(void);
+// Counts a wakeup unless the app already woke up at this point in time
+void host_wakeup(void);
+// Calls back at the given time from the event loop, without counting as
+// an app timer
+void host_schedule_system_event(uint32_t delay_ms, void (*callback)(void *data), void *data);
+void host_app_focus(bool in_focus);
+bool host_count_changed_pixels_enabled(void);
+
+// host_stats.c
+// Counts a frame buffer capture for the plane being drawn
+void host_stats_frame_buffer_captured(void);
+
+// storage.c
+void host_storage_reset(void);
+
+// platform.c
+void host_set_now_ms(uint64_t now_ms);
+bool host_verbose(void);
+
+#endif
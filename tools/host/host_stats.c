@@ -0,0 +1,121 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "host_stats.h"
+#include "host_sdk.h"
+
+#if !defined(RENDER_STATS)
+#error "The host build counts draw calls with RENDER_STATS defined"
+#endif
+
+static HostRenderStats s_stats;
+static RenderPlane s_plane;
+static uint32_t s_plane_draw_calls;
+static uint32_t s_plane_captures;
+static bool s_in_plane;
+static struct timespec s_plane_start;
+static uint64_t s_launch_ms;
+
+static uint64_t prv_elapsed_ns(const struct timespec *from) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)(now.tv_sec - from->tv_sec) * 1000000000u + now.tv_nsec - from->tv_nsec;
+}
+
+void render_stats_begin(RenderPlane plane) {
+  s_plane = plane;
+  s_plane_draw_calls = 0;
+  s_plane_captures = 0;
+  s_in_plane = true;
+  clock_gettime(CLOCK_MONOTONIC, &s_plane_start);
+}
+
+void render_stats_end(RenderPlane plane) {
+  const uint64_t elapsed = prv_elapsed_ns(&s_plane_start);
+  HostPlaneStats *stats = &s_stats.planes[plane];
+  stats->redraws++;
+  stats->draw_calls += s_plane_draw_calls;
+  stats->captures += s_plane_captures;
+  s_in_plane = false;
+  stats->ns += elapsed;
+}
+
+void render_stats_draw_call(void) {
+  s_plane_draw_calls++;
+}
+
+void host_stats_frame_buffer_captured(void) {
+  if (s_in_plane) {
+    s_plane_captures++;
+  }
+}
+
+void render_stats_tick(TimeUnits units_changed) {
+  s_stats.ticks++;
+}
+
+void render_stats_animation_frame(void) {
+  s_stats.animation_frames++;
+}
+
+void render_stats_dirty(bool changed) {
+  s_stats.dirty_marks++;
+  if (!changed) {
+    s_stats.redundant_dirty_marks++;
+  }
+}
+
+void render_stats_dump(void) {
+  for (int i = 0; i < RENDER_PLANE_COUNT; i++) {
+    const HostPlaneStats *stats = &s_stats.planes[i];
+    APP_LOG(APP_LOG_LEVEL_INFO, "%s: %lu redraws, %lu draw calls, %lu captures, %llu ns",
+            host_plane_name(i), (unsigned long)stats->redraws,
+            (unsigned long)stats->draw_calls, (unsigned long)stats->captures,
+            (unsigned long long)stats->ns);
+  }
+}
+
+void render_stats_launch(void) {
+  s_launch_ms = host_now_ms();
+}
+
+// in simulated time, which only moves with the timers
+void render_stats_startup(const char *stage) {
+  APP_LOG(APP_LOG_LEVEL_INFO, "startup: %s after %lu ms", stage,
+          (unsigned long)(host_now_ms() - s_launch_ms));
+}
+
+void render_stats_init(void) {
+}
+
+void render_stats_deinit(void) {
+}
+
+const HostRenderStats *host_render_stats(void) {
+  return &s_stats;
+}
+
+void host_render_stats_reset(void) {
+  memset(&s_stats, 0, sizeof(s_stats));
+}
+
+const char *host_plane_name(RenderPlane plane) {
+  static const char *const names[RENDER_PLANE_COUNT] = { "marks", "day", "clock", "seconds" };
+  return names[plane];
+}
@@ -0,0 +1,50 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HOST_STATS_H
+#define HOST_STATS_H
+
+#include "render_stats.h"
+
+// Render statistics of the host build. host_stats.c implements the
+// render_stats.h API with RENDER_STATS defined: draw calls and time per
+// plane, the time in ns of the host clock, kept for the runners instead of
+// being logged and sent to the phone.
+
+typedef struct {
+  uint32_t redraws;
+  uint32_t draw_calls;
+  // frame buffer captures, the paths writing pixels themselves
+  uint32_t captures;
+  uint64_t ns;
+} HostPlaneStats;
+
+typedef struct {
+  HostPlaneStats planes[RENDER_PLANE_COUNT];
+  uint32_t ticks;
+  uint32_t animation_frames;
+  uint32_t dirty_marks;
+  uint32_t redundant_dirty_marks;
+} HostRenderStats;
+
+const HostRenderStats *host_render_stats(void);
+void host_render_stats_reset(void);
+const char *host_plane_name(RenderPlane plane);
+
+#endif
@@ -0,0 +1,606 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PEBBLE_H
+#define PEBBLE_H
+
+// Host stand-in for the SDK header, with the part of the API the watchface
+// uses. It is built once per platform with PBL_PLATFORM_<NAME> defined and
+// implemented in software by the files next to this folder (see host.h).
+// time() and localtime() read the simulated clock of the host.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "message_keys.auto.h"
+#include "resource_ids.auto.h"
+
+// ---------------------------------------------------------------------------
+// Platforms
+
+#if defined(PBL_PLATFORM_APLITE) || defined(PBL_PLATFORM_DIORITE)
+#define PBL_BW 1
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_false)
+#define PBL_IF_BW_ELSE(if_true, if_false) (if_true)
+#elif defined(PBL_PLATFORM_BASALT) || defined(PBL_PLATFORM_CHALK) || defined(PBL_PLATFORM_EMERY)
+#define PBL_COLOR 1
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_BW_ELSE(if_true, if_false) (if_false)
+#else
+#error "Define one of PBL_PLATFORM_APLITE, BASALT, CHALK, DIORITE or EMERY"
+#endif
+
+#if defined(PBL_PLATFORM_CHALK)
+#define PBL_ROUND 1
+#define PBL_IF_ROUND_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_RECT_ELSE(if_true, if_false) (if_false)
+#define PBL_DISPLAY_WIDTH 180
+#define PBL_DISPLAY_HEIGHT 180
+#else
+#define PBL_RECT 1
+#define PBL_IF_ROUND_ELSE(if_true, if_false) (if_false)
+#define PBL_IF_RECT_ELSE(if_true, if_false) (if_true)
+#if defined(PBL_PLATFORM_EMERY)
+#define PBL_DISPLAY_WIDTH 200
+#define PBL_DISPLAY_HEIGHT 228
+#else
+#define PBL_DISPLAY_WIDTH 144
+#define PBL_DISPLAY_HEIGHT 168
+#endif
+#endif
+
+// APIs missing on some platforms, as PBL_API_EXISTS_<name> set to 0 or 1
+#define PBL_API_EXISTS(api) PBL_API_EXISTS_##api
+#if defined(PBL_PLATFORM_APLITE)
+#define PBL_API_EXISTS_unobstructed_area_service_subscribe 0
+#else
+#define PBL_API_EXISTS_unobstructed_area_service_subscribe 1
+#endif
+
+#define ARRAY_LENGTH(array) (sizeof((array)) / sizeof((array)[0]))
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+
+// ---------------------------------------------------------------------------
+// Logging, time and memory
+
+typedef enum {
+  APP_LOG_LEVEL_ERROR = 1,
+  APP_LOG_LEVEL_WARNING = 50,
+  APP_LOG_LEVEL_INFO = 100,
+  APP_LOG_LEVEL_DEBUG = 200,
+  APP_LOG_LEVEL_DEBUG_VERBOSE = 255,
+} AppLogLevel;
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number,
+             const char *fmt, ...) __attribute__((format(printf, 4, 5)));
+#define APP_LOG(level, fmt, args...) app_log(level, __FILE__, __LINE__, fmt, ## args)
+
+time_t host_time(time_t *tloc);
+struct tm *host_localtime(const time_t *timep);
+#define time(tloc) host_time(tloc)
+#define localtime(timep) host_localtime(timep)
+
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms);
+
+size_t heap_bytes_used(void);
+size_t heap_bytes_free(void);
+
+// ---------------------------------------------------------------------------
+// Graphics types
+
+typedef union GColor8 {
+  uint8_t argb;
+  struct {
+    uint8_t b:2;
+    uint8_t g:2;
+    uint8_t r:2;
+    uint8_t a:2;
+  };
+} GColor8;
+
+typedef GColor8 GColor;
+
+#define GColorClearARGB8 ((uint8_t)0x00)
+#define GColorBlackARGB8 ((uint8_t)0xC0)
+#define GColorWhiteARGB8 ((uint8_t)0xFF)
+#define GColorRedARGB8 ((uint8_t)0xF0)
+#define GColorLightGrayARGB8 ((uint8_t)0xEA)
+#define GColorDarkGrayARGB8 ((uint8_t)0xD5)
+
+#define GColorClear ((GColor8) { .argb = GColorClearARGB8 })
+#define GColorBlack ((GColor8) { .argb = GColorBlackARGB8 })
+#define GColorWhite ((GColor8) { .argb = GColorWhiteARGB8 })
+#define GColorRed ((GColor8) { .argb = GColorRedARGB8 })
+#define GColorLightGray ((GColor8) { .argb = GColorLightGrayARGB8 })
+#define GColorDarkGray ((GColor8) { .argb = GColorDarkGrayARGB8 })
+
+#define GColorFromRGBA(red, green, blue, alpha) ((GColor8) { \
+  .a = (uint8_t)(alpha) >> 6, .r = (uint8_t)(red) >> 6, \
+  .g = (uint8_t)(green) >> 6, .b = (uint8_t)(blue) >> 6 })
+#define GColorFromRGB(red, green, blue) GColorFromRGBA(red, green, blue, 255)
+#define GColorFromHEX(v) GColorFromRGB(((v) >> 16) & 0xff, ((v) >> 8) & 0xff, ((v) & 0xff))
+
+bool gcolor_equal(GColor8 x, GColor8 y);
+GColor8 gcolor_legible_over(GColor8 background_color);
+
+typedef struct GPoint {
+  int16_t x;
+  int16_t y;
+} GPoint;
+
+#define GPoint(x, y) ((GPoint) { (x), (y) })
+#define GPointZero GPoint(0, 0)
+
+typedef struct GSize {
+  int16_t w;
+  int16_t h;
+} GSize;
+
+#define GSize(w, h) ((GSize) { (w), (h) })
+#define GSizeZero GSize(0, 0)
+
+typedef struct GRect {
+  GPoint origin;
+  GSize size;
+} GRect;
+
+#define GRect(x, y, w, h) ((GRect) { { (x), (y) }, { (w), (h) } })
+#define GRectZero GRect(0, 0, 0, 0)
+
+typedef struct GEdgeInsets {
+  int16_t top;
+  int16_t right;
+  int16_t bottom;
+  int16_t left;
+} GEdgeInsets;
+
+#define GEdgeInsets4(t, r, b, l) ((GEdgeInsets) { .top = (t), .right = (r), .bottom = (b), .left = (l) })
+#define GEdgeInsets3(t, rl, b) GEdgeInsets4(t, rl, b, rl)
+#define GEdgeInsets2(tb, rl) GEdgeInsets4(tb, rl, tb, rl)
+#define GEdgeInsets1(trbl) GEdgeInsets4(trbl, trbl, trbl, trbl)
+#define GEdgeInsetsN(_1, _2, _3, _4, NAME, ...) NAME
+#define GEdgeInsets(...) \
+  GEdgeInsetsN(__VA_ARGS__, GEdgeInsets4, GEdgeInsets3, GEdgeInsets2, GEdgeInsets1)(__VA_ARGS__)
+
+typedef enum {
+  GAlignCenter,
+  GAlignTopLeft,
+  GAlignTopRight,
+  GAlignTop,
+  GAlignLeft,
+  GAlignBottom,
+  GAlignRight,
+  GAlignBottomRight,
+  GAlignBottomLeft,
+} GAlign;
+
+bool gpoint_equal(const GPoint * const point_a, const GPoint * const point_b);
+bool gsize_equal(const GSize *size_a, const GSize *size_b);
+bool grect_equal(const GRect * const rect_a, const GRect * const rect_b);
+bool grect_is_empty(const GRect * const rect);
+void grect_standardize(GRect *rect);
+void grect_clip(GRect * const rect_to_clip, const GRect * const rect_clipper);
+bool grect_contains_point(const GRect *rect, const GPoint *point);
+GPoint grect_center_point(const GRect *rect);
+GRect grect_crop(GRect rect, const int32_t crop_size_px);
+GRect grect_inset(GRect rect, GEdgeInsets insets);
+void grect_align(GRect *rect, const GRect *inside_rect, const GAlign alignment, const bool clip);
+
+// ---------------------------------------------------------------------------
+// Trigonometry
+
+#define TRIG_MAX_RATIO 0xffff
+#define TRIG_MAX_ANGLE 0x10000
+#define DEG_TO_TRIGANGLE(angle) (((angle) * TRIG_MAX_ANGLE) / 360)
+#define TRIGANGLE_TO_DEG(trig_angle) (((trig_angle) * 360) / TRIG_MAX_ANGLE)
+
+int32_t sin_lookup(int32_t angle);
+int32_t cos_lookup(int32_t angle);
+int32_t atan2_lookup(int16_t y, int16_t x);
+
+typedef enum {
+  GOvalScaleModeFitCircle,
+  GOvalScaleModeFillCircle,
+} GOvalScaleMode;
+
+GPoint gpoint_from_polar(GRect rect, GOvalScaleMode scale_mode, int32_t angle);
+
+// ---------------------------------------------------------------------------
+// Bitmaps
+
+typedef enum {
+  GBitmapFormat1Bit = 0,
+  GBitmapFormat8Bit,
+  GBitmapFormat1BitPalette,
+  GBitmapFormat2BitPalette,
+  GBitmapFormat4BitPalette,
+  GBitmapFormat8BitCircular,
+} GBitmapFormat;
+
+typedef struct GBitmap GBitmap;
+
+typedef struct GBitmapDataRowInfo {
+  uint8_t *data;
+  int16_t min_x;
+  int16_t max_x;
+} GBitmapDataRowInfo;
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format);
+void gbitmap_destroy(GBitmap *bitmap);
+GRect gbitmap_get_bounds(const GBitmap *bitmap);
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap);
+uint8_t *gbitmap_get_data(const GBitmap *bitmap);
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap, uint16_t y);
+
+// ---------------------------------------------------------------------------
+// Fonts and resources
+
+typedef struct FontInfo *GFont;
+typedef const struct HostResource *ResHandle;
+
+ResHandle resource_get_handle(uint32_t resource_id);
+GFont fonts_load_custom_font(ResHandle handle);
+void fonts_unload_custom_font(GFont font);
+
+// ---------------------------------------------------------------------------
+// Drawing
+
+typedef struct GContext GContext;
+typedef struct GTextAttributes GTextAttributes;
+
+typedef enum {
+  GCompOpAssign,
+  GCompOpAssignInverted,
+  GCompOpOr,
+  GCompOpAnd,
+  GCompOpClear,
+  GCompOpSet,
+} GCompOp;
+
+typedef enum {
+  GCornerNone = 0,
+  GCornerTopLeft = 1 << 0,
+  GCornerTopRight = 1 << 1,
+  GCornerBottomLeft = 1 << 2,
+  GCornerBottomRight = 1 << 3,
+  GCornersAll = GCornerTopLeft | GCornerTopRight | GCornerBottomLeft | GCornerBottomRight,
+  GCornersTop = GCornerTopLeft | GCornerTopRight,
+  GCornersBottom = GCornerBottomLeft | GCornerBottomRight,
+  GCornersLeft = GCornerTopLeft | GCornerBottomLeft,
+  GCornersRight = GCornerTopRight | GCornerBottomRight,
+} GCornerMask;
+
+typedef enum {
+  GTextOverflowModeWordWrap,
+  GTextOverflowModeTrailingEllipsis,
+  GTextOverflowModeFill,
+} GTextOverflowMode;
+
+typedef enum {
+  GTextAlignmentLeft,
+  GTextAlignmentCenter,
+  GTextAlignmentRight,
+} GTextAlignment;
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color);
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_text_color(GContext *ctx, GColor color);
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode);
+void graphics_context_set_antialiased(GContext *ctx, bool enable);
+void graphics_context_set_stroke_width(GContext *ctx, uint8_t stroke_width);
+
+void graphics_draw_pixel(GContext *ctx, GPoint point);
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1);
+void graphics_draw_rect(GContext *ctx, GRect rect);
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius,
+                        GCornerMask corner_mask);
+void graphics_draw_circle(GContext *ctx, GPoint p, uint16_t radius);
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius);
+void graphics_fill_radial(GContext *ctx, GRect rect, GOvalScaleMode scale_mode,
+                          uint16_t inset_thickness, int32_t angle_start, int32_t angle_end);
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect);
+void graphics_draw_text(GContext *ctx, const char *text, GFont const font, const GRect box,
+                        const GTextOverflowMode overflow_mode, const GTextAlignment alignment,
+                        GTextAttributes *text_attributes);
+GSize graphics_text_layout_get_content_size(const char *text, GFont const font,
+                                            const GRect box,
+                                            const GTextOverflowMode overflow_mode,
+                                            const GTextAlignment alignment);
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx);
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer);
+
+// ---------------------------------------------------------------------------
+// Layers and windows
+
+typedef struct Layer Layer;
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+
+Layer *layer_create(GRect frame);
+void layer_destroy(Layer *layer);
+void layer_mark_dirty(Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_set_frame(Layer *layer, GRect frame);
+GRect layer_get_frame(const Layer *layer);
+void layer_set_bounds(Layer *layer, GRect bounds);
+GRect layer_get_bounds(const Layer *layer);
+GRect layer_get_unobstructed_bounds(const Layer *layer);
+void layer_add_child(Layer *parent, Layer *child);
+void layer_remove_from_parent(Layer *child);
+void layer_set_hidden(Layer *layer, bool hidden);
+
+typedef struct Window Window;
+typedef void (*WindowHandler)(Window *window);
+
+typedef struct WindowHandlers {
+  WindowHandler load;
+  WindowHandler appear;
+  WindowHandler disappear;
+  WindowHandler unload;
+} WindowHandlers;
+
+Window *window_create(void);
+void window_destroy(Window *window);
+void window_set_window_handlers(Window *window, WindowHandlers handlers);
+void window_set_background_color(Window *window, GColor background_color);
+Layer *window_get_root_layer(const Window *window);
+void window_stack_push(Window *window, bool animated);
+
+// ---------------------------------------------------------------------------
+// Animations
+
+typedef struct Animation Animation;
+typedef int32_t AnimationProgress;
+
+#define ANIMATION_NORMALIZED_MIN 0
+#define ANIMATION_NORMALIZED_MAX 65535
+
+typedef enum {
+  AnimationCurveLinear,
+  AnimationCurveEaseIn,
+  AnimationCurveEaseOut,
+  AnimationCurveEaseInOut,
+  AnimationCurveDefault = AnimationCurveEaseInOut,
+} AnimationCurve;
+
+typedef void (*AnimationStartedHandler)(Animation *animation, void *context);
+typedef void (*AnimationStoppedHandler)(Animation *animation, bool finished, void *context);
+
+typedef struct AnimationHandlers {
+  AnimationStartedHandler started;
+  AnimationStoppedHandler stopped;
+} AnimationHandlers;
+
+typedef void (*AnimationSetupImplementation)(Animation *animation);
+typedef void (*AnimationUpdateImplementation)(Animation *animation,
+                                              const AnimationProgress progress);
+typedef void (*AnimationTeardownImplementation)(Animation *animation);
+
+typedef struct AnimationImplementation {
+  AnimationSetupImplementation setup;
+  AnimationUpdateImplementation update;
+  AnimationTeardownImplementation teardown;
+} AnimationImplementation;
+
+Animation *animation_create(void);
+bool animation_destroy(Animation *animation);
+bool animation_set_implementation(Animation *animation,
+                                  const AnimationImplementation *implementation);
+bool animation_set_duration(Animation *animation, uint32_t duration_ms);
+bool animation_set_delay(Animation *animation, uint32_t delay_ms);
+bool animation_set_curve(Animation *animation, AnimationCurve curve);
+bool animation_set_handlers(Animation *animation, AnimationHandlers callbacks, void *context);
+void *animation_get_context(Animation *animation);
+bool animation_schedule(Animation *animation);
+bool animation_unschedule(Animation *animation);
+bool animation_is_scheduled(Animation *animation);
+
+// ---------------------------------------------------------------------------
+// Timers and services
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data);
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer *timer_handle);
+
+typedef enum {
+  SECOND_UNIT = 1 << 0,
+  MINUTE_UNIT = 1 << 1,
+  HOUR_UNIT = 1 << 2,
+  DAY_UNIT = 1 << 3,
+  MONTH_UNIT = 1 << 4,
+  YEAR_UNIT = 1 << 5,
+} TimeUnits;
+
+typedef void (*TickHandler)(struct tm *tick_time, TimeUnits units_changed);
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+
+typedef enum {
+  ACCEL_AXIS_X = 0,
+  ACCEL_AXIS_Y = 1,
+  ACCEL_AXIS_Z = 2,
+} AccelAxisType;
+
+typedef void (*AccelTapHandler)(AccelAxisType axis, int32_t direction);
+void accel_tap_service_subscribe(AccelTapHandler handler);
+void accel_tap_service_unsubscribe(void);
+
+typedef struct BatteryChargeState {
+  uint8_t charge_percent;
+  bool is_charging;
+  bool is_plugged;
+} BatteryChargeState;
+
+typedef void (*BatteryStateHandler)(BatteryChargeState charge);
+BatteryChargeState battery_state_service_peek(void);
+
+typedef void (*AppFocusHandler)(bool in_focus);
+
+typedef struct AppFocusHandlers {
+  AppFocusHandler will_focus;
+  AppFocusHandler did_focus;
+} AppFocusHandlers;
+
+void app_focus_service_subscribe_handlers(AppFocusHandlers handlers);
+void app_focus_service_unsubscribe(void);
+
+typedef struct ConnectionHandlers {
+  void (*pebble_app_connection_handler)(bool connected);
+  void (*pebblekit_connection_handler)(bool connected);
+} ConnectionHandlers;
+
+typedef void (*HealthEventHandler)(int event, void *context);
+
+typedef void (*UnobstructedAreaWillChangeHandler)(GRect final_unobstructed_screen_area,
+                                                  void *context);
+typedef void (*UnobstructedAreaChangeHandler)(AnimationProgress progress, void *context);
+typedef void (*UnobstructedAreaDidChangeHandler)(void *context);
+
+typedef struct UnobstructedAreaHandlers {
+  UnobstructedAreaWillChangeHandler will_change;
+  UnobstructedAreaChangeHandler change;
+  UnobstructedAreaDidChangeHandler did_change;
+} UnobstructedAreaHandlers;
+
+// ---------------------------------------------------------------------------
+// Dictionaries and messages
+
+typedef enum {
+  TUPLE_BYTE_ARRAY = 0,
+  TUPLE_CSTRING = 1,
+  TUPLE_UINT = 2,
+  TUPLE_INT = 3,
+} TupleType;
+
+typedef struct __attribute__((__packed__)) {
+  uint32_t key;
+  TupleType type:8;
+  uint16_t length;
+  union {
+    uint8_t data[0];
+    char cstring[0];
+    uint8_t uint8;
+    uint16_t uint16;
+    uint32_t uint32;
+    int8_t int8;
+    int16_t int16;
+    int32_t int32;
+  } value[];
+} Tuple;
+
+typedef struct Dictionary Dictionary;
+
+typedef struct DictionaryIterator {
+  Dictionary *dictionary;
+  const void *end;
+  Tuple *cursor;
+} DictionaryIterator;
+
+typedef enum {
+  DICT_OK = 0,
+  DICT_NOT_ENOUGH_STORAGE = 1 << 1,
+  DICT_INVALID_ARGS = 1 << 2,
+} DictionaryResult;
+
+typedef enum {
+  APP_MSG_OK = 0,
+  APP_MSG_SEND_TIMEOUT = 1 << 1,
+  APP_MSG_BUSY = 1 << 6,
+  APP_MSG_INVALID_ARGS = 1 << 7,
+} AppMessageResult;
+
+typedef void (*AppMessageInboxReceived)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageInboxDropped)(AppMessageResult reason, void *context);
+typedef void (*AppMessageOutboxSent)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageOutboxFailed)(DictionaryIterator *iterator, AppMessageResult reason,
+                                       void *context);
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...);
+DictionaryResult dict_write_begin(DictionaryIterator *iter, uint8_t * const buffer,
+                                  const uint16_t size);
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key,
+                                 const uint8_t * const data, const uint16_t size);
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key,
+                                  const uint8_t value);
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key,
+                                  const int32_t value);
+uint32_t dict_write_end(DictionaryIterator *iter);
+Tuple *dict_read_begin_from_buffer(DictionaryIterator *iter, const uint8_t * const buffer,
+                                   const uint16_t size);
+Tuple *dict_read_first(DictionaryIterator *iter);
+Tuple *dict_read_next(DictionaryIterator *iter);
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key);
+
+typedef void (*DictionaryKeyUpdatedCallback)(const uint32_t key, const Tuple *new_tuple,
+                                             const Tuple *old_tuple, void *context);
+
+uint32_t dict_size(DictionaryIterator *iter);
+DictionaryResult dict_merge(DictionaryIterator *dest, uint32_t *dest_max_size_in_out,
+                            DictionaryIterator *source, const bool update_existing_keys_only,
+                            const DictionaryKeyUpdatedCallback key_callback, void *context);
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator);
+AppMessageResult app_message_outbox_send(void);
+
+// ---------------------------------------------------------------------------
+// Storage
+
+typedef enum StatusCode {
+  S_TRUE = 1,
+  S_FALSE = 0,
+  S_SUCCESS = 0,
+  E_ERROR = -1,
+  E_UNKNOWN = -2,
+  E_INVALID_ARGUMENT = -3,
+  E_OUT_OF_MEMORY = -4,
+  E_OUT_OF_STORAGE = -5,
+  E_OUT_OF_RESOURCES = -6,
+  E_RANGE = -7,
+  E_DOES_NOT_EXIST = -8,
+  E_INVALID_OPERATION = -9,
+  E_BUSY = -10,
+} StatusCode;
+
+#define PERSIST_DATA_MAX_LENGTH 256
+#define PERSIST_STRING_MAX_LENGTH PERSIST_DATA_MAX_LENGTH
+
+bool persist_exists(const uint32_t key);
+int persist_get_size(const uint32_t key);
+int32_t persist_read_int(const uint32_t key);
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size);
+int persist_write_int(const uint32_t key, const int32_t value);
+int persist_write_data(const uint32_t key, const void *data, const size_t size);
+int persist_delete(const uint32_t key);
+
+// ---------------------------------------------------------------------------
+// App
+
+void app_event_loop(void);
+
+#endif
@@ -0,0 +1,295 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "host_sdk.h"
+
+// Layer tree and window stack. The firmware draws the whole tree of the
+// top window whenever a layer was marked dirty, each layer clipped to its
+// frame inside its parent's; so does host_render_if_dirty(), called by the
+// event loop after every event.
+
+struct Layer {
+  GRect frame;
+  GRect bounds;
+  LayerUpdateProc update_proc;
+  bool hidden;
+  Layer *parent;
+  Layer *first_child;
+  Layer *next_sibling;
+  Window *window;
+};
+
+struct Window {
+  Layer *root_layer;
+  WindowHandlers handlers;
+  GColor background_color;
+  bool loaded;
+};
+
+static Window *s_top_window;
+static bool s_dirty;
+static int16_t s_obstruction;
+
+void host_layers_reset(void) {
+  s_top_window = NULL;
+  s_dirty = false;
+  s_obstruction = 0;
+}
+
+static void prv_mark_window_dirty(const Layer *layer) {
+  while (layer->parent) {
+    layer = layer->parent;
+  }
+  if (layer->window && layer->window == s_top_window) {
+    s_dirty = true;
+  }
+}
+
+Layer *layer_create(GRect frame) {
+  Layer *layer = calloc(1, sizeof(Layer));
+  if (layer) {
+    layer->frame = frame;
+    layer->bounds = (GRect) { .size = frame.size };
+  }
+  return layer;
+}
+
+void layer_destroy(Layer *layer) {
+  if (layer) {
+    layer_remove_from_parent(layer);
+    // children stay around, only unlinked like on the watch
+    for (Layer *child = layer->first_child; child; child = child->next_sibling) {
+      child->parent = NULL;
+    }
+    free(layer);
+  }
+}
+
+void layer_mark_dirty(Layer *layer) {
+  prv_mark_window_dirty(layer);
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+  layer->update_proc = update_proc;
+}
+
+void layer_set_frame(Layer *layer, GRect frame) {
+  if (grect_equal(&frame, &layer->frame)) {
+    return;
+  }
+  // bounds that matched the frame follow its size
+  if (gpoint_equal(&layer->bounds.origin, &GPointZero) &&
+      gsize_equal(&layer->bounds.size, &layer->frame.size)) {
+    layer->bounds.size = frame.size;
+  }
+  layer->frame = frame;
+  prv_mark_window_dirty(layer);
+}
+
+GRect layer_get_frame(const Layer *layer) {
+  return layer->frame;
+}
+
+void layer_set_bounds(Layer *layer, GRect bounds) {
+  if (grect_equal(&bounds, &layer->bounds)) {
+    return;
+  }
+  layer->bounds = bounds;
+  prv_mark_window_dirty(layer);
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+  return layer->bounds;
+}
+
+// Screen position of the layer's bounds origin
+static GPoint prv_layer_offset(const Layer *layer) {
+  GPoint offset = GPointZero;
+  for (; layer; layer = layer->parent) {
+    offset.x += layer->frame.origin.x + layer->bounds.origin.x;
+    offset.y += layer->frame.origin.y + layer->bounds.origin.y;
+  }
+  return offset;
+}
+
+GRect layer_get_unobstructed_bounds(const Layer *layer) {
+  const GPoint offset = prv_layer_offset(layer);
+  GRect area = GRect(-offset.x, -offset.y, PBL_DISPLAY_WIDTH,
+                     PBL_DISPLAY_HEIGHT - s_obstruction);
+  GRect bounds = layer->bounds;
+  grect_clip(&bounds, &area);
+  return bounds;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+  layer_remove_from_parent(child);
+  child->parent = parent;
+  Layer **link = &parent->first_child;
+  while (*link) {
+    link = &(*link)->next_sibling;
+  }
+  *link = child;
+  prv_mark_window_dirty(parent);
+}
+
+void layer_remove_from_parent(Layer *child) {
+  if (!child->parent) {
+    return;
+  }
+  prv_mark_window_dirty(child->parent);
+  for (Layer **link = &child->parent->first_child; *link; link = &(*link)->next_sibling) {
+    if (*link == child) {
+      *link = child->next_sibling;
+      break;
+    }
+  }
+  child->parent = NULL;
+  child->next_sibling = NULL;
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+  if (layer->hidden != hidden) {
+    layer->hidden = hidden;
+    prv_mark_window_dirty(layer);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Windows
+
+Window *window_create(void) {
+  Window *window = calloc(1, sizeof(Window));
+  if (!window) {
+    return NULL;
+  }
+  window->root_layer = layer_create(GRect(0, 0, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT));
+  window->root_layer->window = window;
+  window->background_color = GColorWhite;
+  return window;
+}
+
+void window_destroy(Window *window) {
+  if (!window) {
+    return;
+  }
+  if (window->loaded && window->handlers.unload) {
+    window->handlers.unload(window);
+  }
+  if (s_top_window == window) {
+    s_top_window = NULL;
+  }
+  layer_destroy(window->root_layer);
+  free(window);
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+  window->handlers = handlers;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+  window->background_color = background_color;
+  prv_mark_window_dirty(window->root_layer);
+}
+
+Layer *window_get_root_layer(const Window *window) {
+  return window->root_layer;
+}
+
+static void prv_push_transition_done(void *data) {
+  host_app_focus(true);
+}
+
+void window_stack_push(Window *window, bool animated) {
+  s_top_window = window;
+  if (!window->loaded) {
+    window->loaded = true;
+    if (window->handlers.load) {
+      window->handlers.load(window);
+    }
+  }
+  if (window->handlers.appear) {
+    window->handlers.appear(window);
+  }
+  s_dirty = true;
+  // the app gets focus once the window slid in
+  host_schedule_system_event(animated ? HOST_PUSH_TRANSITION_MS : 0, prv_push_transition_done,
+                             NULL);
+}
+
+// ---------------------------------------------------------------------------
+// Rendering
+
+static void prv_render_layer(Layer *layer, GPoint origin, GRect clip) {
+  if (layer->hidden) {
+    return;
+  }
+  // frame in screen coordinates, clipped to the parent's
+  GRect frame = layer->frame;
+  frame.origin.x += origin.x;
+  frame.origin.y += origin.y;
+  grect_clip(&clip, &frame);
+  if (grect_is_empty(&clip)) {
+    return;
+  }
+  const GPoint offset = GPoint(frame.origin.x + layer->bounds.origin.x,
+                               frame.origin.y + layer->bounds.origin.y);
+  if (layer->update_proc) {
+    host_counters_mutable()->pixels_drawn += clip.size.w * clip.size.h;
+    layer->update_proc(layer, host_graphics_context(offset, clip));
+  }
+  for (Layer *child = layer->first_child; child; child = child->next_sibling) {
+    prv_render_layer(child, offset, clip);
+  }
+}
+
+void host_render_if_dirty(void) {
+  if (!s_dirty || !s_top_window) {
+    return;
+  }
+  s_dirty = false;
+  HostCounters *counters = host_counters_mutable();
+  counters->frames++;
+  const GRect screen = GRect(0, 0, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT);
+  GBitmap *before = host_count_changed_pixels_enabled() ? host_frame_buffer_copy() : NULL;
+  if (!gcolor_equal(s_top_window->background_color, GColorClear)) {
+    GContext *ctx = host_graphics_context(GPointZero, screen);
+    graphics_context_set_fill_color(ctx, s_top_window->background_color);
+    graphics_fill_rect(ctx, screen, 0, GCornerNone);
+    counters->pixels_drawn += screen.size.w * screen.size.h;
+  }
+  prv_render_layer(s_top_window->root_layer, GPointZero, screen);
+  if (before) {
+    counters->pixels_changed += host_frame_buffer_diff(before, host_frame_buffer());
+    gbitmap_destroy(before);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Unobstructed area
+
+int16_t host_obstruction(void) {
+  return s_obstruction;
+}
+
+void host_set_obstruction_now(int16_t height) {
+  s_obstruction = height;
+  if (s_top_window) {
+    prv_mark_window_dirty(s_top_window->root_layer);
+  }
+}
@@ -0,0 +1,153 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "host_sdk.h"
+#include <malloc.h>
+#include <stdarg.h>
+
+// Simulated clock, logging, heap figures and the launch of the app.
+
+static uint64_t s_now_ms;
+static HostScenario s_scenario;
+static bool s_verbose;
+static struct tm s_tm;
+
+uint64_t host_now_ms(void) {
+  return s_now_ms;
+}
+
+void host_set_now_ms(uint64_t now_ms) {
+  s_now_ms = now_ms;
+}
+
+time_t host_time(time_t *tloc) {
+  const time_t now = s_now_ms / 1000;
+  if (tloc) {
+    *tloc = now;
+  }
+  return now;
+}
+
+// The host runs in UTC, so local time is the simulated time as it is
+struct tm *host_localtime(const time_t *timep) {
+  return gmtime_r(timep, &s_tm);
+}
+
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms) {
+  const uint16_t ms = s_now_ms % 1000;
+  if (t_utc) {
+    *t_utc = s_now_ms / 1000;
+  }
+  if (out_ms) {
+    *out_ms = ms;
+  }
+  return ms;
+}
+
+void host_set_verbose(bool verbose) {
+  s_verbose = verbose;
+}
+
+bool host_verbose(void) {
+  return s_verbose;
+}
+
+// Warnings and errors always show, the rest with host_set_verbose()
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number,
+             const char *fmt, ...) {
+  if (!s_verbose && log_level > APP_LOG_LEVEL_WARNING) {
+    return;
+  }
+  const char *name = strrchr(src_filename, '/');
+  fprintf(stderr, "[%llu] %s:%d> ", (unsigned long long)s_now_ms, name ? name + 1 : src_filename,
+          src_line_number);
+  va_list args;
+  va_start(args, fmt);
+  vfprintf(stderr, fmt, args);
+  va_end(args);
+  fputc('\n', stderr);
+}
+
+// Heap of the whole host process, only good for differences
+size_t heap_bytes_used(void) {
+  return mallinfo2().uordblks;
+}
+
+size_t heap_bytes_free(void) {
+  return mallinfo2().fordblks;
+}
+
+const char *host_platform(void) {
+#if defined(PBL_PLATFORM_APLITE)
+  return "aplite";
+#elif defined(PBL_PLATFORM_BASALT)
+  return "basalt";
+#elif defined(PBL_PLATFORM_CHALK)
+  return "chalk";
+#elif defined(PBL_PLATFORM_DIORITE)
+  return "diorite";
+#else
+  return "emery";
+#endif
+}
+
+bool host_parse_hex(const char *hex, uint8_t *data, size_t capacity, uint16_t *size) {
+  const size_t length = strlen(hex);
+  if (length % 2 || length / 2 > capacity) {
+    return false;
+  }
+  for (size_t i = 0; i < length / 2; i++) {
+    unsigned int byte;
+    if (sscanf(&hex[2 * i], "%2x", &byte) != 1) {
+      return false;
+    }
+    data[i] = byte;
+  }
+  *size = length / 2;
+  return true;
+}
+
+void host_init(time_t launch_time, HostScenario scenario) {
+  s_now_ms = (uint64_t)launch_time * 1000;
+  s_scenario = scenario;
+  // taps and pushes drawn by the runners repeat from run to run
+  srand(1);
+  host_graphics_init();
+  host_counters_reset();
+}
+
+static void prv_reset(void) {
+  host_events_reset();
+  host_layers_reset();
+  host_storage_reset();
+}
+
+void host_launch(void) {
+  prv_reset();
+  vuela_main();
+  prv_reset();
+}
+
+// The first frame is drawn before the runner's scenario takes over
+void app_event_loop(void) {
+  host_render_if_dirty();
+  if (s_scenario) {
+    s_scenario();
+  }
+}
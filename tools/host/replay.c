@@ -0,0 +1,209 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "host.h"
+#include "host_stats.h"
+
+// Replays a simulated day through the real handlers: minute and second
+// ticks into prv_handle_time_update (hour boundaries included), taps into
+// accel_tap_handler, settings pushes into watch_model_handle_config_change
+// and Timeline Quick View slides, while the battery drains. Prints one CSV
+// row with what the day cost: wakeups, frames, pixels drawn and changed,
+// primitives and frame buffer captures. tools/host/replay.py runs it for
+// every platform and settings variant.
+//
+//   replay [--label NAME] [--settings HEX] [--seed N] [--hours N] [--header]
+
+// 2024-03-17 00:00:00 UTC
+#define DAY_START 1710633600
+#define HOUR_MS (60 * 60 * 1000)
+#define MINUTE_MS (60 * 1000)
+// awake from 7:00 to 23:00, when taps and Quick View happen
+#define WAKE_HOUR 7
+#define SLEEP_HOUR 23
+// taps come every 5 to 40 minutes while awake
+#define TAP_MIN_GAP_MS (5 * MINUTE_MS)
+#define TAP_MAX_GAP_MS (40 * MINUTE_MS)
+// height of the Timeline Quick View
+#define QUICK_VIEW_HEIGHT 51
+// the battery loses a percent every 15 minutes, 4% an hour
+#define DRAIN_MS (15 * MINUTE_MS)
+
+typedef enum {
+  REPLAY_TAP,
+  REPLAY_PUSH,
+  REPLAY_QUICK_VIEW_IN,
+  REPLAY_QUICK_VIEW_OUT,
+  REPLAY_BATTERY,
+} ReplayKind;
+
+typedef struct {
+  uint64_t offset_ms;
+  ReplayKind kind;
+} ReplayEvent;
+
+#define MAX_EVENTS 512
+
+static ReplayEvent s_events[MAX_EVENTS];
+static int s_event_count;
+static const char *s_label = "defaults";
+static uint32_t s_seed = 1;
+static int s_hours = 24;
+static uint8_t s_settings[256];
+static uint16_t s_settings_size;
+static uint32_t s_random;
+
+// Same sequence on every host, unlike rand()
+static uint32_t prv_random(uint32_t range) {
+  s_random = s_random * 1103515245 + 12345;
+  return (s_random >> 8) % range;
+}
+
+static void prv_add(uint64_t offset_ms, ReplayKind kind) {
+  if (s_event_count < MAX_EVENTS && offset_ms < (uint64_t)s_hours * HOUR_MS) {
+    s_events[s_event_count++] = (ReplayEvent) { offset_ms, kind };
+  }
+}
+
+static int prv_compare(const void *a, const void *b) {
+  const ReplayEvent *event_a = a;
+  const ReplayEvent *event_b = b;
+  return event_a->offset_ms < event_b->offset_ms ? -1 : event_a->offset_ms > event_b->offset_ms;
+}
+
+// Taps while awake, the settings page saved in the morning and the
+// evening, three Quick View events of ten minutes, the battery draining
+static void prv_plan_day(void) {
+  s_random = s_seed;
+  uint64_t tap = (uint64_t)WAKE_HOUR * HOUR_MS;
+  while (true) {
+    tap += TAP_MIN_GAP_MS + prv_random(TAP_MAX_GAP_MS - TAP_MIN_GAP_MS);
+    if (tap >= (uint64_t)SLEEP_HOUR * HOUR_MS) {
+      break;
+    }
+    prv_add(tap, REPLAY_TAP);
+  }
+  prv_add(9 * HOUR_MS + 30 * MINUTE_MS, REPLAY_PUSH);
+  prv_add(18 * HOUR_MS + 45 * MINUTE_MS, REPLAY_PUSH);
+  static const int quick_view_hours[] = { 8, 13, 19 };
+  for (unsigned i = 0; i < ARRAY_LENGTH(quick_view_hours); i++) {
+    const uint64_t start = quick_view_hours[i] * (uint64_t)HOUR_MS + prv_random(HOUR_MS);
+    prv_add(start, REPLAY_QUICK_VIEW_IN);
+    prv_add(start + 10 * MINUTE_MS, REPLAY_QUICK_VIEW_OUT);
+  }
+  for (uint64_t drain = DRAIN_MS; drain < (uint64_t)s_hours * HOUR_MS; drain += DRAIN_MS) {
+    prv_add(drain, REPLAY_BATTERY);
+  }
+  qsort(s_events, s_event_count, sizeof(ReplayEvent), prv_compare);
+}
+
+static void prv_play(const ReplayEvent *event) {
+  switch (event->kind) {
+    case REPLAY_TAP:
+      host_tap();
+      break;
+    case REPLAY_PUSH:
+      // the phone sends every setting on each save, most often unchanged
+      if (s_settings_size) {
+        host_receive_message(s_settings, s_settings_size);
+      }
+      break;
+    case REPLAY_QUICK_VIEW_IN:
+      host_set_obstruction(QUICK_VIEW_HEIGHT);
+      break;
+    case REPLAY_QUICK_VIEW_OUT:
+      host_set_obstruction(0);
+      break;
+    case REPLAY_BATTERY:
+      host_set_battery((BatteryChargeState) {
+        .charge_percent = 100 - event->offset_ms / DRAIN_MS,
+      });
+      break;
+  }
+}
+
+static uint32_t prv_primitives(uint32_t *captures) {
+  const HostRenderStats *stats = host_render_stats();
+  uint32_t primitives = 0;
+  *captures = 0;
+  for (int plane = 0; plane < RENDER_PLANE_COUNT; plane++) {
+    primitives += stats->planes[plane].draw_calls;
+    *captures += stats->planes[plane].captures;
+  }
+  return primitives;
+}
+
+static void prv_replay(void) {
+  const uint64_t start_ms = host_now_ms();
+  // the settings the day runs with are in place from the start
+  if (s_settings_size) {
+    host_receive_message(s_settings, s_settings_size);
+  }
+  for (int i = 0; i < s_event_count; i++) {
+    const uint64_t at = start_ms + s_events[i].offset_ms;
+    if (at > host_now_ms()) {
+      host_run_for(at - host_now_ms());
+    }
+    prv_play(&s_events[i]);
+  }
+  host_run_for(start_ms + (uint64_t)s_hours * HOUR_MS - host_now_ms());
+  const HostCounters *counters = host_counters();
+  uint32_t captures;
+  const uint32_t primitives = prv_primitives(&captures);
+  printf("%s,%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%llu,%llu,%lu,%lu\n", s_label, host_platform(),
+         (unsigned long)s_seed, (unsigned long)counters->wakeups, (unsigned long)counters->ticks,
+         (unsigned long)counters->timers, (unsigned long)counters->animation_frames,
+         (unsigned long)counters->taps, (unsigned long)counters->messages_in,
+         (unsigned long)counters->frames, (unsigned long long)counters->pixels_drawn,
+         (unsigned long long)counters->pixels_changed, (unsigned long)primitives,
+         (unsigned long)captures);
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--header") == 0) {
+      printf("label,platform,seed,wakeups,ticks,timers,animation_frames,taps,messages,frames,"
+             "pixels_drawn,pixels_changed,primitives,captures\n");
+      return 0;
+    }
+    else if (strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+      s_label = argv[++i];
+    }
+    else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      s_seed = strtoul(argv[++i], NULL, 10);
+    }
+    else if (strcmp(argv[i], "--hours") == 0 && i + 1 < argc) {
+      s_hours = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--settings") == 0 && i + 1 < argc &&
+             host_parse_hex(argv[i + 1], s_settings, sizeof(s_settings), &s_settings_size)) {
+      i++;
+    }
+    else {
+      fprintf(stderr, "usage: %s [--label NAME] [--settings HEX] [--seed N] [--hours N] "
+              "[--header]\n", argv[0]);
+      return 1;
+    }
+  }
+  prv_plan_day();
+  host_init(DAY_START, prv_replay);
+  host_count_changed_pixels(true);
+  host_launch();
+  return 0;
+}
@@ -0,0 +1,140 @@
+"""Replays a simulated day on every platform for each settings variant.
+
+Runs build/host/<platform>/replay (see replay.c) for the defaults of
+config.json and for each setting changed on its own, in parallel, and
+writes what each day cost to a CSV file: wakeups, ticks, timers,
+animation frames, frames, pixels drawn and changed, primitives and frame
+buffer captures. Every run gets all the settings, the way Clay sends them
+on each save, with the defaults it would show on that platform.
+
+Variants: toggles flipped, colors swapped between black and white, the
+first, middle and last of the other options of selects and radio groups,
+sliders at both ends. Settings that only matter with another one turned on
+are varied with it on (see DEPENDS).
+
+    make -C tools/host replay
+
+builds the runners and writes build/host/replay.csv.
+"""
+
+import csv
+import io
+import os
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor
+
+from settings_message import ROOT, load_config, load_message_keys, message, settings_items
+
+PLATFORMS = ('aplite', 'basalt', 'chalk', 'diorite', 'emery')
+
+# SDK capabilities of each platform, as used by config.json
+CAPABILITIES = {
+    'aplite': ('PLATFORM_APLITE', 'BW', 'RECT'),
+    'basalt': ('PLATFORM_BASALT', 'COLOR', 'RECT', 'HEALTH'),
+    'chalk': ('PLATFORM_CHALK', 'COLOR', 'ROUND', 'HEALTH'),
+    'diorite': ('PLATFORM_DIORITE', 'BW', 'RECT', 'HEALTH'),
+    'emery': ('PLATFORM_EMERY', 'COLOR', 'RECT', 'HEALTH'),
+}
+
+# settings with no effect unless another one has the given value
+DEPENDS = {
+    'seconds_burst_duration': {'seconds_burst': True},
+    'battery_saver_start': {'battery_saver_enabled': True},
+    'battery_saver_stop': {'battery_saver_enabled': True},
+    'saver_quality': {'battery_saver_enabled': True},
+    'intro_duration': {'intro_enabled': True},
+}
+
+
+def supported(item, platform):
+    for capability in item.get('capabilities', []):
+        negated = capability.startswith('NOT_')
+        if (capability[4:] if negated else capability) in CAPABILITIES[platform]:
+            if negated:
+                return False
+        elif not negated:
+            return False
+    return True
+
+
+def defaults(config, platform):
+    """{messageKey: default} of the items built for the platform"""
+    values = {}
+    for item in config:
+        if item['type'] == 'section':
+            for key, value in defaults(item['items'], platform).items():
+                values.setdefault(key, value)
+        elif 'messageKey' in item and 'defaultValue' in item and supported(item, platform):
+            values.setdefault(item['messageKey'], item['defaultValue'])
+    return values
+
+
+def alternatives(item):
+    """Values other than the default to try the item with"""
+    default = item.get('defaultValue')
+    if item['type'] == 'toggle':
+        return [not default]
+    if item['type'] == 'color':
+        return ['FFFFFF' if str(default).upper() != 'FFFFFF' else '000000']
+    if item['type'] in ('select', 'radiogroup'):
+        others = [option['value'] for option in item.get('options', []) if option['value'] != default]
+        picks = [others[0], others[len(others) // 2], others[-1]] if others else []
+        return sorted(set(picks), key=picks.index)
+    if item['type'] == 'slider':
+        return [value for value in (item.get('min', 0), item.get('max', 100)) if value != default]
+    return []
+
+
+def variants(config):
+    """[(label, {messageKey: value})], the defaults first"""
+    result = [('defaults', {})]
+    for key, item in settings_items(config).items():
+        for value in alternatives(item):
+            changes = dict(DEPENDS.get(key, {}))
+            changes[key] = value
+            label = ';'.join('%s=%s' % (name, json_value(changes[name])) for name in sorted(changes))
+            result.append((label, changes))
+    return result
+
+
+def json_value(value):
+    return str(value).lower() if isinstance(value, bool) else str(value)
+
+
+def run(build, platform, label, changes, args):
+    values = defaults(args.config_json, platform)
+    values.update(changes)
+    command = [os.path.join(build, platform, 'replay'), '--label', label,
+               '--seed', str(args.seed), '--hours', str(args.hours),
+               '--settings', message(args.config_json, args.message_keys, values).hex()]
+    return subprocess.run(command, check=True, stdout=subprocess.PIPE,
+                          universal_newlines=True).stdout
+
+
+if __name__ == '__main__':
+    import argparse
+    parser = argparse.ArgumentParser(description='Replays a day for every platform and settings variant')
+    parser.add_argument('--build', action='store', default=os.path.join(ROOT, 'build', 'host'),
+                        help='Folder of the host build')
+    parser.add_argument('--output', action='store', default=None, help='CSV file, build/host/replay.csv by default')
+    parser.add_argument('--platform', action='append', choices=PLATFORMS, help='Platform to run, all by default')
+    parser.add_argument('--jobs', action='store', type=int, default=os.cpu_count(), help='Runs at once')
+    parser.add_argument('--seed', action='store', type=int, default=1, help='Seed of the taps and Quick View times')
+    parser.add_argument('--hours', action='store', type=int, default=24, help='Length of the day')
+    args = parser.parse_args()
+    args.config_json = load_config()
+    args.message_keys = load_message_keys()
+    platforms = args.platform or PLATFORMS
+    matrix = [(platform, label, changes) for label, changes in variants(args.config_json)
+              for platform in platforms]
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        rows = list(pool.map(lambda cell: run(args.build, *cell, args=args), matrix))
+    header = subprocess.run([os.path.join(args.build, platforms[0], 'replay'), '--header'],
+                            check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+    output = args.output or os.path.join(args.build, 'replay.csv')
+    with open(output, 'w', newline='') as f:
+        writer = csv.writer(f)
+        for line in [header] + rows:
+            writer.writerows(csv.reader(io.StringIO(line)))
+    sys.stderr.write('%d runs written to %s\n' % (len(rows), output))
@@ -0,0 +1,139 @@
+"""Packs settings into the message the watch receives from the phone.
+
+The message holds one byte array under the settings_payload key, laid out
+like src/js/settings_payload.js builds it and derived from config.json with
+the helpers enamel generates the watch side with: version, uint32 mask of
+the settings sent, toggles and checkbox groups as bits, then the other
+settings sent in order, little endian. The dictionary is serialized the
+way the watch reads it from its inbox: a tuple count, then the message key
+(numbered from package.json like the SDK does), type, length and value.
+
+    python3 tools/host/settings_message.py display_date=true clock_font=ROUNDED
+
+prints the message in hex, the way the host runners take it.
+"""
+
+import json
+import os
+import struct
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+sys.path.append(os.path.join(ROOT, 'node_modules'))
+
+from enamel.enamel import getOptionArray, payloadbit, payloadbitcount, payloadsettings, \
+    payloadsize, recordtype, recordversion  # noqa: E402
+
+MESSAGE_KEY_BASE = 10000
+TUPLE_BYTE_ARRAY = 0
+SIZES = {'uint8_t': 1, 'int16_t': 2, 'int32_t': 4, 'uint32_t': 4}
+
+
+def load_config(path=os.path.join(ROOT, 'src', 'js', 'config.json')):
+    with open(path) as f:
+        return json.load(f)
+
+
+def load_message_keys(path=os.path.join(ROOT, 'package.json')):
+    with open(path) as f:
+        keys = json.load(f)['pebble']['messageKeys']
+    return dict((key.split('[')[0], MESSAGE_KEY_BASE + index) for index, key in enumerate(keys))
+
+
+def settings_items(config):
+    """{messageKey: item} of the items holding a setting, the first of each key"""
+    items = {}
+    for item in config:
+        if item['type'] == 'section':
+            for key, inner in settings_items(item['items']).items():
+                items.setdefault(key, inner)
+        elif 'messageKey' in item:
+            items.setdefault(item['messageKey'], item)
+    return items
+
+
+def color_byte(value):
+    rgb = int(value.lstrip('#').replace('0x', ''), 16) if isinstance(value, str) else value
+    return 0xc0 | ((rgb >> 22) & 0x3) << 4 | ((rgb >> 14) & 0x3) << 2 | ((rgb >> 6) & 0x3)
+
+
+def uint_bytes(value, size):
+    return [(value >> (8 * i)) & 0xff for i in range(size)]
+
+
+def utf8_bytes(text, limit):
+    """As many whole characters as fit in limit bytes, like settings_payload.js"""
+    encoded = b''
+    for char in text:
+        char_bytes = char.encode('utf-8', 'replace')
+        if len(encoded) + len(char_bytes) > limit:
+            break
+        encoded += char_bytes
+    return encoded
+
+
+def value_bytes(item, value):
+    kind = recordtype(item)
+    if item['type'] == 'color':
+        return [color_byte(value)]
+    if kind == 'uint8_t':
+        options = [option['value'] for option in getOptionArray(item)]
+        return [options.index(value) if value in options else 0]
+    if kind == 'uint32_t':
+        parts = [int(part) for part in str(value).split(':')]
+        return uint_bytes(parts[0] * 3600 + parts[1] * 60 + (parts[2] if len(parts) > 2 else 0), 4)
+    if kind == 'char':
+        return list(utf8_bytes(str(value), 99)) + [0]
+    return uint_bytes(int(value), SIZES[kind])
+
+
+def pack(config, values):
+    """Return the payload as bytes for the given {messageKey: value}, None when empty"""
+    mask = 0
+    bits = [0] * ((payloadbitcount(config) + 7) // 8)
+    fields = []
+    for index, (id, items) in enumerate(payloadsettings(config)):
+        item = items[0]
+        if item['messageKey'] not in values:
+            continue
+        value = values[item['messageKey']]
+        mask |= 1 << index
+        flags = [value] if item['type'] == 'toggle' else value if item['type'] == 'checkboxgroup' else []
+        for offset, flag in enumerate(flags):
+            bit = payloadbit(id, config) + offset
+            if flag:
+                bits[bit >> 3] |= 1 << (bit & 7)
+        if payloadsize(item) or recordtype(item) == 'char':
+            fields += value_bytes(item, value)
+    if not mask:
+        return None
+    return bytes([recordversion(config)] + uint_bytes(mask, 4) + bits + fields)
+
+
+def message(config, message_keys, values):
+    """Return the serialized dictionary for the given {messageKey: value}"""
+    payload = pack(config, values)
+    if not payload:
+        return struct.pack('<B', 0)
+    return struct.pack('<BIBH', 1, message_keys['settings_payload'], TUPLE_BYTE_ARRAY,
+                       len(payload)) + payload
+
+
+def parse_value(text):
+    """true, false and numbers as JSON, anything else as a string"""
+    try:
+        return json.loads(text)
+    except ValueError:
+        return text
+
+
+if __name__ == '__main__':
+    import argparse
+    parser = argparse.ArgumentParser(description='Packs settings into the message the phone sends')
+    parser.add_argument('settings', nargs='*', help='messageKey=value')
+    parser.add_argument('--config', action='store', default=None, help='Path to the Clay configuration file')
+    args = parser.parse_args()
+    config = load_config(args.config) if args.config else load_config()
+    values = dict((key, parse_value(value)) for key, value in
+                  (setting.split('=', 1) for setting in args.settings))
+    print(message(config, load_message_keys(), values).hex())
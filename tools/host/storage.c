@@ -0,0 +1,287 @@
+/*
+    Copyright (C) 2022 Gonzalo Munoz.
+
+    This file is part of Vuela.
+
+    Vuela is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vuela.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "host_sdk.h"
+#include <stdarg.h>
+
+// Persistent storage in memory, dropped by host_persist_clear(), and
+// dictionaries in the layout of the firmware: a tuple count followed by
+// packed tuples.
+
+#define PERSIST_MAX_KEYS 64
+
+typedef struct {
+  uint32_t key;
+  int size;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistEntry;
+
+static PersistEntry s_entries[PERSIST_MAX_KEYS];
+static int s_entry_count;
+
+static PersistEntry *prv_find(uint32_t key) {
+  for (int i = 0; i < s_entry_count; i++) {
+    if (s_entries[i].key == key) {
+      return &s_entries[i];
+    }
+  }
+  return NULL;
+}
+
+void host_persist_clear(void) {
+  s_entry_count = 0;
+}
+
+void host_storage_reset(void) {
+  // storage outlives the app, like on the watch
+}
+
+bool persist_exists(const uint32_t key) {
+  return prv_find(key) != NULL;
+}
+
+int persist_get_size(const uint32_t key) {
+  const PersistEntry *entry = prv_find(key);
+  return entry ? entry->size : E_DOES_NOT_EXIST;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+  int32_t value = 0;
+  persist_read_data(key, &value, sizeof(value));
+  return value;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size) {
+  const PersistEntry *entry = prv_find(key);
+  if (!entry) {
+    return E_DOES_NOT_EXIST;
+  }
+  const int size = MIN((int)buffer_size, entry->size);
+  memcpy(buffer, entry->data, size);
+  return size;
+}
+
+int persist_write_int(const uint32_t key, const int32_t value) {
+  persist_write_data(key, &value, sizeof(value));
+  return sizeof(value);
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size) {
+  PersistEntry *entry = prv_find(key);
+  if (!entry) {
+    if (s_entry_count == PERSIST_MAX_KEYS) {
+      return E_OUT_OF_STORAGE;
+    }
+    entry = &s_entries[s_entry_count++];
+    entry->key = key;
+  }
+  entry->size = MIN(size, PERSIST_DATA_MAX_LENGTH);
+  memcpy(entry->data, data, entry->size);
+  return entry->size;
+}
+
+int persist_delete(const uint32_t key) {
+  PersistEntry *entry = prv_find(key);
+  if (!entry) {
+    return E_DOES_NOT_EXIST;
+  }
+  *entry = s_entries[--s_entry_count];
+  return S_TRUE;
+}
+
+// ---------------------------------------------------------------------------
+// Dictionaries
+
+struct Dictionary {
+  uint8_t count;
+  Tuple head[];
+} __attribute__((__packed__));
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...) {
+  uint32_t size = sizeof(Dictionary) + tuple_count * sizeof(Tuple);
+  va_list sizes;
+  va_start(sizes, tuple_count);
+  for (int i = 0; i < tuple_count; i++) {
+    size += va_arg(sizes, uint32_t);
+  }
+  va_end(sizes);
+  return size;
+}
+
+DictionaryResult dict_write_begin(DictionaryIterator *iter, uint8_t * const buffer,
+                                  const uint16_t size) {
+  if (!iter || !buffer || size < sizeof(Dictionary)) {
+    return DICT_INVALID_ARGS;
+  }
+  iter->dictionary = (Dictionary *)buffer;
+  iter->dictionary->count = 0;
+  iter->cursor = iter->dictionary->head;
+  iter->end = buffer + size;
+  return DICT_OK;
+}
+
+static DictionaryResult prv_write(DictionaryIterator *iter, uint32_t key, TupleType type,
+                                  const void *data, uint16_t size) {
+  if (!iter || !iter->dictionary) {
+    return DICT_INVALID_ARGS;
+  }
+  uint8_t *tuple_end = (uint8_t *)iter->cursor + sizeof(Tuple) + size;
+  if (tuple_end > (const uint8_t *)iter->end) {
+    return DICT_NOT_ENOUGH_STORAGE;
+  }
+  iter->cursor->key = key;
+  iter->cursor->type = type;
+  iter->cursor->length = size;
+  memcpy(iter->cursor->value->data, data, size);
+  iter->cursor = (Tuple *)tuple_end;
+  iter->dictionary->count++;
+  return DICT_OK;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key,
+                                 const uint8_t * const data, const uint16_t size) {
+  return prv_write(iter, key, TUPLE_BYTE_ARRAY, data, size);
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key,
+                                  const uint8_t value) {
+  return prv_write(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key,
+                                  const int32_t value) {
+  return prv_write(iter, key, TUPLE_INT, &value, sizeof(value));
+}
+
+uint32_t dict_write_end(DictionaryIterator *iter) {
+  if (!iter || !iter->dictionary) {
+    return 0;
+  }
+  iter->end = iter->cursor;
+  return (uint8_t *)iter->cursor - (uint8_t *)iter->dictionary;
+}
+
+Tuple *dict_read_begin_from_buffer(DictionaryIterator *iter, const uint8_t * const buffer,
+                                   const uint16_t size) {
+  if (!iter) {
+    return NULL;
+  }
+  iter->dictionary = (Dictionary *)buffer;
+  iter->end = buffer + size;
+  if (!buffer || size < sizeof(Dictionary)) {
+    iter->cursor = NULL;
+    return NULL;
+  }
+  return dict_read_first(iter);
+}
+
+static bool prv_tuple_fits(const DictionaryIterator *iter, const Tuple *tuple) {
+  const uint8_t *start = (const uint8_t *)tuple;
+  return start + sizeof(Tuple) <= (const uint8_t *)iter->end &&
+         start + sizeof(Tuple) + tuple->length <= (const uint8_t *)iter->end;
+}
+
+Tuple *dict_read_first(DictionaryIterator *iter) {
+  if (!iter->dictionary || iter->dictionary->count == 0) {
+    return NULL;
+  }
+  iter->cursor = iter->dictionary->head;
+  return prv_tuple_fits(iter, iter->cursor) ? iter->cursor : NULL;
+}
+
+Tuple *dict_read_next(DictionaryIterator *iter) {
+  if (!iter->cursor) {
+    return NULL;
+  }
+  // stop after the last tuple even when the buffer is longer
+  int index = 0;
+  for (uint8_t *tuple = (uint8_t *)iter->dictionary->head; tuple < (uint8_t *)iter->cursor;
+       tuple += sizeof(Tuple) + ((Tuple *)tuple)->length) {
+    index++;
+  }
+  if (index + 1 >= iter->dictionary->count) {
+    iter->cursor = NULL;
+    return NULL;
+  }
+  Tuple *next = (Tuple *)((uint8_t *)iter->cursor + sizeof(Tuple) + iter->cursor->length);
+  iter->cursor = next;
+  return prv_tuple_fits(iter, next) ? next : NULL;
+}
+
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key) {
+  DictionaryIterator copy = *iter;
+  for (Tuple *tuple = dict_read_first(&copy); tuple; tuple = dict_read_next(&copy)) {
+    if (tuple->key == key) {
+      return tuple;
+    }
+  }
+  return NULL;
+}
+
+uint32_t dict_size(DictionaryIterator *iter) {
+  DictionaryIterator copy = *iter;
+  const uint8_t *end = (const uint8_t *)iter->dictionary + sizeof(Dictionary);
+  for (Tuple *tuple = dict_read_first(&copy); tuple; tuple = dict_read_next(&copy)) {
+    end = (const uint8_t *)tuple + sizeof(Tuple) + tuple->length;
+  }
+  return end - (const uint8_t *)iter->dictionary;
+}
+
+// Rewrites dest in place: its tuples, replaced by those of source with the
+// same key, then the keys only source has
+DictionaryResult dict_merge(DictionaryIterator *dest, uint32_t *dest_max_size_in_out,
+                            DictionaryIterator *source, const bool update_existing_keys_only,
+                            const DictionaryKeyUpdatedCallback key_callback, void *context) {
+  if (!dest || !dest->dictionary || !dest_max_size_in_out || !source) {
+    return DICT_INVALID_ARGS;
+  }
+  const uint32_t old_size = dict_size(dest);
+  uint8_t *old_buffer = malloc(old_size);
+  memcpy(old_buffer, dest->dictionary, old_size);
+  DictionaryIterator old;
+  dict_read_begin_from_buffer(&old, old_buffer, old_size);
+
+  DictionaryResult result = dict_write_begin(dest, (uint8_t *)dest->dictionary,
+                                             *dest_max_size_in_out);
+  for (Tuple *tuple = dict_read_first(&old); tuple && result == DICT_OK;
+       tuple = dict_read_next(&old)) {
+    const Tuple *update = dict_find(source, tuple->key);
+    const Tuple *value = update ? update : tuple;
+    result = prv_write(dest, value->key, value->type, value->value->data, value->length);
+  }
+  DictionaryIterator copy = *source;
+  for (Tuple *tuple = dict_read_first(&copy); tuple && result == DICT_OK;
+       tuple = dict_read_next(&copy)) {
+    if (!update_existing_keys_only && !dict_find(&old, tuple->key)) {
+      result = prv_write(dest, tuple->key, tuple->type, tuple->value->data, tuple->length);
+    }
+  }
+  *dest_max_size_in_out = dict_write_end(dest);
+
+  copy = *source;
+  for (Tuple *tuple = dict_read_first(&copy); tuple && result == DICT_OK && key_callback;
+       tuple = dict_read_next(&copy)) {
+    const Tuple *new_tuple = dict_find(dest, tuple->key);
+    if (new_tuple) {
+      key_callback(tuple->key, new_tuple, dict_find(&old, tuple->key), context);
+    }
+  }
+  free(old_buffer);
+  return result;
+}
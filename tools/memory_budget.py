@@ -0,0 +1,98 @@
+"""Writes the static memory budget of an app binary (memory_budget.txt).
+
+Everything in the app's ELF that is allocated (code, data and bss) is
+loaded in the app's RAM, the rest of it is the heap. The largest blocks the
+watchface keeps on the heap depend only on the screen, so they are
+estimated here to show how much is left for everything else before
+the app ever runs. The actual peak is logged by MEMORY_STATS builds.
+"""
+
+import os
+import struct
+
+from dial_geometry import SCREEN_SIZES
+
+# app RAM in bytes: code, data, bss and heap
+APP_RAM = {
+    'aplite': 24 * 1024,
+    'basalt': 64 * 1024,
+    'chalk': 64 * 1024,
+    'diorite': 64 * 1024,
+    'emery': 128 * 1024,
+}
+
+BLACK_AND_WHITE = ('aplite', 'diorite')
+
+# platforms replaying a display list of the dial instead of a bitmap copy,
+# its buffer is static (see dial_cache.h)
+DIAL_LIST = ('aplite', 'diorite')
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+
+def elf_sections(path):
+    """Returns (name, type, flags, size) for each section of a 32 bit little endian ELF."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:4] != b'\x7fELF':
+        raise ValueError('%s is not an ELF file' % path)
+    shoff, = struct.unpack_from('<I', data, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data, 0x2e)
+    headers = [struct.unpack_from('<IIIIIIIIII', data, shoff + i * shentsize) for i in range(shnum)]
+    names = headers[shstrndx][4]
+    sections = []
+    for header in headers:
+        name_end = data.index(b'\0', names + header[0])
+        name = data[names + header[0]:name_end].decode('ascii')
+        sections.append((name, header[1], header[2], header[5]))
+    return sections
+
+
+def bitmap_bytes(width, height, black_and_white):
+    if black_and_white:
+        return (width + 31) // 32 * 4 * height
+    return width * height
+
+
+def budget(platform, elf_path, dial_cache=None):
+    sections = [s for s in elf_sections(elf_path) if s[2] & SHF_ALLOC]
+    static = sum(s[3] for s in sections)
+    ram = APP_RAM[platform]
+    width, height = SCREEN_SIZES[platform]
+    blocks = []
+    if (dial_cache or ('list' if platform in DIAL_LIST else 'bitmap')) == 'bitmap':
+        # the dial cache spans the whole screen
+        blocks.append(('dial cache', bitmap_bytes(width, height, platform in BLACK_AND_WHITE)))
+    heap = ram - static
+    left = heap - sum(size for _, size in blocks)
+
+    lines = ['%s memory budget' % platform, '']
+    lines += ['%-12s %6d bytes' % (name, size) for name, _, _, size in sections]
+    lines += [
+        '%-12s %6d bytes' % ('static', static),
+        '%-12s %6d bytes' % ('heap', heap),
+    ]
+    lines += ['%-12s %6d bytes' % (name, size) for name, size in blocks]
+    lines += [
+        '%-12s %6d bytes (%d%% of %d)' % ('left', left, left * 100 // ram, ram),
+        '',
+    ]
+    return left, '\n'.join(lines)
+
+
+def memory_budget(task):
+    platform = task.env.PLATFORM_NAME
+    left, report = budget(platform, task.inputs[0].abspath(), os.environ.get('VUELA_DIAL_CACHE'))
+    with open(task.outputs[0].abspath(), 'w') as f:
+        f.write(report)
+    print('%s: %d bytes of heap left after the static footprint and caches' % (platform, left))
+
+
+if __name__ == '__main__':
+    import argparse
+    parser = argparse.ArgumentParser(description='Prints the static memory budget of an app binary')
+    parser.add_argument('platform', choices=sorted(APP_RAM), help='Target platform')
+    parser.add_argument('elf', help='Path to pebble-app.elf')
+    result = parser.parse_args()
+    print(budget(result.platform, result.elf)[1])